@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "ComputeOptions.h"
+#include "Scattering.h"
+#include "SpecialFunctions.h"
+
+namespace Scattering
+{
+
+	// compares the ways of computing the Bessel functions over the orders and arguments a computation with the options needs
+	// each of them is timed and compared with the reference one, the standard library if available, otherwise the stable recurrence
+	// the errors are relative, but for l < x, where the functions oscillate, they are relative to the amplitude sqrt(j^2 + n^2), to avoid the zeroes
+	// for large l and small x n overflows and j underflows, those values are not compared, they are counted separately (the phase shifts are 0 there)
+	// so are the values that are not finite for a method while the reference ones are, the upward recurrence for j overflows for l much larger than x
+	class BesselTest
+	{
+	public:
+		struct Result
+		{
+			SpecialFunctions::BesselMethod method;
+			bool available;
+			bool reference;
+			double nanoseconds; // per table
+			double maxError; // for j and n
+			double maxDerivativeError; // for their derivatives
+			unsigned long long nrValues; // the orders for all the samples
+			unsigned long long outOfRange; // the ones with reference values outside the double range, not compared
+			unsigned long long notFinite; // the ones with values that are not finite, while the reference ones are, not compared
+		};
+
+		static std::vector<Result> Run(const ComputeOptions& options, unsigned int nrSamples = 2000)
+		{
+			const unsigned int L = Scattering::getMaxPartialWave(options);
+
+			double xmin;
+			double xmax;
+			Scattering::getBesselArgumentRange(options, xmin, xmax);
+
+			std::vector<double> x(nrSamples);
+			for (unsigned int i = 0; i < nrSamples; ++i)
+				x[i] = xmin + (xmax - xmin) * i / std::max(nrSamples - 1, 1U);
+
+			const SpecialFunctions::BesselMethod referenceMethod = SpecialFunctions::isStandardLibraryAvailable() ? SpecialFunctions::StandardLibrary : SpecialFunctions::StableRecurrence;
+
+			std::vector<SpecialFunctions::BesselTable> reference(nrSamples);
+			for (unsigned int i = 0; i < nrSamples; ++i)
+				reference[i].Compute(L, x[i], referenceMethod);
+
+			std::vector<Result> results;
+			for (int m = SpecialFunctions::StandardLibrary; m <= SpecialFunctions::StableRecurrence; ++m)
+			{
+				Result result{};
+				result.method = static_cast<SpecialFunctions::BesselMethod>(m);
+				result.available = SpecialFunctions::StandardLibrary != result.method || SpecialFunctions::isStandardLibraryAvailable();
+				result.reference = referenceMethod == result.method;
+
+				if (result.available)
+				{
+					std::vector<SpecialFunctions::BesselTable> tables(nrSamples);
+
+					const auto start = std::chrono::steady_clock::now();
+					for (unsigned int i = 0; i < nrSamples; ++i)
+						tables[i].Compute(L, x[i], result.method);
+					const auto end = std::chrono::steady_clock::now();
+
+					result.nanoseconds = std::chrono::duration<double, std::nano>(end - start).count() / nrSamples;
+					result.nrValues = static_cast<unsigned long long>(nrSamples) * (L + 1ULL);
+
+					for (unsigned int i = 0; i < nrSamples; ++i)
+						for (unsigned int l = 0; l <= L; ++l)
+						{
+							const SpecialFunctions::BesselTable& ref = reference[i];
+							const SpecialFunctions::BesselTable& table = tables[i];
+							const bool oscillating = l < x[i];
+
+							if (!isInRange(ref, l))
+							{
+								++result.outOfRange;
+								continue;
+							}
+							else if (!std::isfinite(table.j(l)) || !std::isfinite(table.n(l)) || !std::isfinite(table.jderiv(l)) || !std::isfinite(table.nderiv(l)))
+							{
+								++result.notFinite;
+								continue;
+							}
+
+							const double amplitude = sqrt(ref.j(l) * ref.j(l) + ref.n(l) * ref.n(l));
+							result.maxError = std::max(result.maxError, Error(table.j(l), ref.j(l), oscillating ? amplitude : std::abs(ref.j(l))));
+							result.maxError = std::max(result.maxError, Error(table.n(l), ref.n(l), oscillating ? amplitude : std::abs(ref.n(l))));
+
+							const double derivAmplitude = sqrt(ref.jderiv(l) * ref.jderiv(l) + ref.nderiv(l) * ref.nderiv(l));
+							result.maxDerivativeError = std::max(result.maxDerivativeError, Error(table.jderiv(l), ref.jderiv(l), oscillating ? derivAmplitude : std::abs(ref.jderiv(l))));
+							result.maxDerivativeError = std::max(result.maxDerivativeError, Error(table.nderiv(l), ref.nderiv(l), oscillating ? derivAmplitude : std::abs(ref.nderiv(l))));
+						}
+				}
+
+				results.push_back(result);
+			}
+
+			return results;
+		}
+
+		static const char* getName(SpecialFunctions::BesselMethod method)
+		{
+			switch (method)
+			{
+			case SpecialFunctions::StandardLibrary:
+				return "Standard library";
+			case SpecialFunctions::UpwardRecurrence:
+				return "Upward recurrence";
+			default:
+				break;
+			}
+
+			return "Stable recurrence";
+		}
+
+		// a line for each method, with the range that was tested at the top
+		static std::string Report(const ComputeOptions& options, const std::vector<Result>& results)
+		{
+			double xmin;
+			double xmax;
+			Scattering::getBesselArgumentRange(options, xmin, xmax);
+
+			char buffer[256];
+			snprintf(buffer, sizeof(buffer), "l from 0 to %u, x from %g to %g\n\n", Scattering::getMaxPartialWave(options), xmin, xmax);
+			std::string report = buffer;
+
+			for (const Result& result : results)
+			{
+				if (!result.available)
+					snprintf(buffer, sizeof(buffer), "%s: not available\n", getName(result.method));
+				else if (result.reference)
+					snprintf(buffer, sizeof(buffer), "%s: %.0f ns per table (reference)\n", getName(result.method), result.nanoseconds);
+				else
+					snprintf(buffer, sizeof(buffer), "%s: %.0f ns per table, max error %s, derivatives %s\n", getName(result.method), result.nanoseconds, FormatError(result.maxError).c_str(), FormatError(result.maxDerivativeError).c_str());
+
+				report += buffer;
+
+				if (result.available && result.outOfRange)
+				{
+					snprintf(buffer, sizeof(buffer), "  %llu of %llu values out of the double range, not compared\n", result.outOfRange, result.nrValues);
+					report += buffer;
+				}
+
+				if (result.available && result.notFinite)
+				{
+					snprintf(buffer, sizeof(buffer), "  %llu of %llu values not finite, not compared\n", result.notFinite, result.nrValues);
+					report += buffer;
+				}
+			}
+
+			return report;
+		}
+
+	private:
+		// for the reference values: n and its derivative finite, j and its derivative not underflowed (they are compared relative to themselves for l > x)
+		static bool isInRange(const SpecialFunctions::BesselTable& table, unsigned int l)
+		{
+			return table.isFinite(l) && std::abs(table.j(l)) >= std::numeric_limits<double>::min() && std::abs(table.jderiv(l)) >= std::numeric_limits<double>::min();
+		}
+
+		// the relative error can be larger than the largest double, for the upward recurrence for j with l much larger than x
+		static std::string FormatError(double error)
+		{
+			if (!std::isfinite(error)) return ">1e308";
+
+			char buffer[32];
+			snprintf(buffer, sizeof(buffer), "%.2e", error);
+
+			return buffer;
+		}
+
+		static double Error(double value, double reference, double scale)
+		{
+			if (value == reference) return 0;
+			else if (0 == scale) return std::numeric_limits<double>::infinity();
+
+			return std::abs(value - reference) / scale;
+		}
+	};
+
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <typeindex>
+
+#include "Potential.h"
+#include "PotentialGrid.h"
+#include "ResultCache.h"
+#include "ThreadPool.h"
+
+namespace Scattering
+{
+
+	// keeps the tabulated potentials between computations, so a new computation with the same potential and integration grid does not tabulate it again
+	// the effective potentials for each l are kept with them
+	// if the memory used goes over the limit, the least recently used ones are dropped
+	class PotentialGridCache
+	{
+	public:
+		explicit PotentialGridCache(size_t maxBytes = 256 * 1024 * 1024) : m_maxBytes(maxBytes) {}
+
+		PotentialGridCache(const PotentialGridCache&) = delete;
+		PotentialGridCache& operator=(const PotentialGridCache&) = delete;
+
+		// the grid from startR to maxr with nrSteps, as used by the computation, see Scattering::ComputeCrossSections
+		// the effective potentials are tabulated later, for the l needed, the memory limit counts them for l up to nrPartialWaves - 1 from the start
+		template<class PotentialT> std::shared_ptr<const PotentialGrid> Get(const PotentialT& potential, double startR, double maxr, unsigned int nrSteps, unsigned int nrPartialWaves)
+		{
+			const Key key{ std::type_index(typeid(PotentialT)), potential.getEpsilon(), potential.getConstant(), getShapeParameter(potential), startR, maxr, nrSteps };
+
+			// the grid is tabulated outside the lock, so the computations that need other grids are not blocked by it
+			// the ones needing the same grid wait for the one that started tabulating it
+			std::promise<std::shared_ptr<const PotentialGrid>> promise;
+			std::shared_future<std::shared_ptr<const PotentialGrid>> grid;
+			bool tabulate = false;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				Entry& entry = m_grids[key];
+				entry.lastUse = ++m_useCounter;
+
+				const bool morePartialWaves = nrPartialWaves > entry.nrPartialWaves;
+				if (morePartialWaves) entry.nrPartialWaves = nrPartialWaves;
+
+				if (!entry.grid.valid())
+				{
+					entry.grid = promise.get_future().share();
+					tabulate = true;
+				}
+
+				grid = entry.grid;
+
+				// a computation with more partial waves than the ones before will tabulate more effective potentials in the grid, which could go over the limit
+				if (!tabulate && morePartialWaves) Evict(key);
+			}
+
+			if (tabulate)
+			{
+				try
+				{
+					const double h = (maxr - startR) / nrSteps;
+					const unsigned int steps = static_cast<unsigned int>(ceil((maxr - startR) / h));
+
+					promise.set_value(std::make_shared<const PotentialGrid>(potential, startR, startR + h, steps, h));
+				}
+				catch (...)
+				{
+					// the entry is dropped before the waiting ones get the exception, too, so the next computation tries again
+					{
+						std::lock_guard<std::mutex> lock(m_mutex);
+						m_grids.erase(key);
+					}
+
+					promise.set_exception(std::current_exception());
+					throw;
+				}
+
+				std::lock_guard<std::mutex> lock(m_mutex);
+				Evict(key);
+			}
+
+			return grid.get();
+		}
+
+		void Clear()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_grids.clear();
+		}
+
+	private:
+		// the potentials with more shapes for the same epsilon and rho
+		template<class PotentialT> static double getShapeParameter(const PotentialT& /*potential*/) { return 0; }
+		static double getShapeParameter(const LennardJones1264Potential& potential) { return potential.getGamma(); }
+
+		// the potential type and parameters, rho is in the start and end positions
+		typedef std::tuple<std::type_index, double, double, double, double, double, unsigned int> Key;
+
+		struct Entry
+		{
+			std::shared_future<std::shared_ptr<const PotentialGrid>> grid;
+			uint64_t lastUse = 0;
+			unsigned int nrPartialWaves = 0; // the most used by a computation, see Get
+
+			bool isReady() const { return grid.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+		};
+
+		// the grids still in use by a computation are kept alive by it
+		// the ones still being tabulated are not counted and not dropped
+		void Evict(const Key& keep)
+		{
+			size_t size = 0;
+			for (const auto& grid : m_grids)
+				if (grid.second.isReady())
+					size += grid.second.grid.get()->getMemorySize(grid.second.nrPartialWaves);
+
+			while (size > m_maxBytes)
+			{
+				auto oldest = m_grids.end();
+				for (auto it = m_grids.begin(); it != m_grids.end(); ++it)
+					if (it->first != keep && it->second.isReady() && (oldest == m_grids.end() || it->second.lastUse < oldest->second.lastUse))
+						oldest = it;
+
+				if (oldest == m_grids.end()) break;
+
+				size -= oldest->second.grid.get()->getMemorySize(oldest->second.nrPartialWaves);
+				m_grids.erase(oldest);
+			}
+		}
+
+		size_t m_maxBytes;
+
+		std::mutex m_mutex;
+		std::map<Key, Entry> m_grids;
+		uint64_t m_useCounter = 0;
+	};
+
+
+	// what's kept between computations: the threads and the cached data, the tabulated potentials and the results
+	class ComputeContext
+	{
+	public:
+		// 0 means as many threads as the hardware supports
+		explicit ComputeContext(unsigned int nrThreads = 0) : threadPool(nrThreads) {}
+
+		ComputeContext(const ComputeContext&) = delete;
+		ComputeContext& operator=(const ComputeContext&) = delete;
+
+		ThreadPool threadPool;
+		PotentialGridCache gridCache;
+		ResultCache resultCache;
+	};
+
+}
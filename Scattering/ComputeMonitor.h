@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Scattering
+{
+
+	// optional, passed to Scattering::Compute to follow the computation while it runs, or to stop it
+	// the functions are called from the pool threads, concurrently, so the implementations must be thread safe and they should return fast
+	class ComputeMonitor
+	{
+	public:
+		virtual ~ComputeMonitor() = default;
+
+		// the points computed so far for a batch of energies, energies in meV and cross sections in rho^2, as in the results of Compute
+		// they come in no particular order, with the adaptive energy grid not even for a single call
+		// pair is the index in the pairs passed to Compute, 0 if there is only one
+		virtual void OnPoints(size_t /*pair*/, const std::pair<double, double>* /*points*/, size_t /*count*/) {}
+
+		// checked before each partial wave of each batch of energies, if true the computation stops as soon as possible
+		// the results of a cancelled computation are empty and they are not cached
+		virtual bool isCancelled() const { return false; }
+	};
+
+
+	// passes the calls for one of the pairs computed at once to the monitor of the whole computation, with the index of the pair
+	class PairMonitor : public ComputeMonitor
+	{
+	public:
+		PairMonitor(ComputeMonitor& monitor, size_t pair) : m_monitor(monitor), m_pair(pair) {}
+
+		void OnPoints(size_t /*pair*/, const std::pair<double, double>* points, size_t count) override
+		{
+			m_monitor.OnPoints(m_pair, points, count);
+		}
+
+		bool isCancelled() const override
+		{
+			return m_monitor.isCancelled();
+		}
+
+	private:
+		ComputeMonitor& m_monitor;
+		size_t m_pair;
+	};
+
+
+	// passes only the cancellation, for computations with points that are not results, the ones for fitting, for example
+	class CancellationMonitor : public ComputeMonitor
+	{
+	public:
+		explicit CancellationMonitor(const ComputeMonitor* monitor) : m_monitor(monitor) {}
+
+		bool isCancelled() const override
+		{
+			return m_monitor && m_monitor->isCancelled();
+		}
+
+	private:
+		const ComputeMonitor* m_monitor;
+	};
+
+
+	// collects the points as they are computed, for another thread to take them, the GUI one, for example, to show them while computing
+	// the pool threads add them in batches of a few points, so a lock held just for appending them is not contended much
+	class PointsStream : public ComputeMonitor
+	{
+	public:
+		// for a new computation, it must not be called while one is still running
+		void Reset(size_t nrPairs)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_points.assign(nrPairs, std::vector<std::pair<double, double>>());
+			m_nrPoints = 0;
+			m_notified = false;
+			m_cancelled = false;
+		}
+
+		// called on the computing thread when points are added and the ones added before were already taken
+		// so there is at most one notification waiting for Take, the points added meanwhile are taken with the notified ones
+		// it must not be changed while computing
+		void setNotify(std::function<void()>&& notify)
+		{
+			m_notify = std::move(notify);
+		}
+
+		void OnPoints(size_t pair, const std::pair<double, double>* points, size_t count) override
+		{
+			bool notify = false;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				if (pair >= m_points.size()) return;
+
+				m_points[pair].insert(m_points[pair].end(), points, points + count);
+				m_nrPoints += count;
+
+				notify = !m_notified;
+				m_notified = true;
+			}
+
+			if (notify && m_notify) m_notify();
+		}
+
+		// the points added since the last call, for each pair
+		// swaps the buffers, so the caller's ones are reused, they are cleared first
+		void Take(std::vector<std::vector<std::pair<double, double>>>& points)
+		{
+			for (auto& pairPoints : points)
+				pairPoints.clear();
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			points.resize(m_points.size());
+			points.swap(m_points);
+			m_notified = false;
+		}
+
+		// all the points added since Reset, including the ones taken
+		size_t getNrPoints()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			return m_nrPoints;
+		}
+
+		// can be called from any thread, the computation stops soon after
+		void Cancel()
+		{
+			m_cancelled = true;
+		}
+
+		bool isCancelled() const override
+		{
+			return m_cancelled;
+		}
+
+	private:
+		std::mutex m_mutex;
+		std::vector<std::vector<std::pair<double, double>>> m_points;
+		size_t m_nrPoints = 0;
+		bool m_notified = false;
+		std::function<void()> m_notify;
+		std::atomic_bool m_cancelled{ false };
+	};
+
+}
@@ -0,0 +1,8 @@
+#include "ComputeOptions.h"
+
+
+const std::vector<Scattering::ScatteringPair> ComputeOptions::scatteringPairs = { 
+	{ "H-Ne", 1.9, 3.15, 1, 20}, {"H-Ar", 4.16, 3.62, 1, 40}, {"H-Kr", 5.9, 3.57, 1, 84}, {"H-Xe", 7.08, 3.82, 1, 131}
+	// with better Bessel functions still does not appear to work correctly for H2, so those will not be available from options
+	, {"H2-Ar", 6.3, 3.57, 2, 40}, {"H2-Kr", 7.19, 3.72, 2, 84}, {"H2-Xe", 8.1, 3.92, 2, 131} 
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ScatteringPair.h"
+#include "SpecialFunctions.h"
+
+// the options for a computation, without the wxWidgets dependent parts, so the computing code can be used without the GUI
+// see Options for the ones that are saved and loaded by the GUI
+class ComputeOptions
+{
+public:
+	// ints, to be usable with the wxWidgets validators
+	enum PotentialType : int
+	{
+		LennardJones126 = 0,
+		LennardJones86,
+		LennardJones106,
+		LennardJones1264
+	};
+
+	enum Engine : int
+	{
+		NumerovEngine = 0,
+		LogDerivativeEngine
+	};
+
+	int nrPoints = 1000;
+	int scatteringPair = 2;
+	int nrIntegrationSteps = 1000;
+	int nrThreads = 0; // 0 means use all the available cores
+	int potentialType = LennardJones126;
+	double gamma = 0.5; // for the 12-6-4 potential
+
+	// if adaptive, partial waves are added until their cross section is under tolerance (relative to the sum) for 'negligiblePartialWaves' consecutive l
+	// otherwise a fixed number of partial waves is used
+	bool adaptivePartialWaves = false;
+	int maxPartialWaves = 30;
+	double partialWavesTolerance = 1E-5;
+	unsigned int negligiblePartialWaves = 3;
+
+	// if adaptive, the energy grid starts coarse and the intervals where the cross section changes relatively more than energyTolerance
+	// or a phase shift changes more than maxPhaseShiftChange (radians) are bisected, until nrPoints is reached
+	bool adaptiveEnergyGrid = false;
+	double energyTolerance = 0.01;
+	double maxPhaseShiftChange = 0.1;
+
+	// if adaptive, the number of integration steps is chosen for each batch of energies and l, doubling it until the phase shifts change less than phaseShiftAccuracy (radians)
+	// but without going over maxIntegrationSteps, otherwise nrIntegrationSteps is used
+	bool adaptiveIntegration = false;
+	double phaseShiftAccuracy = 1E-3;
+	int maxIntegrationSteps = 131072;
+
+	// Numerov with the logarithmic derivative from the last step, as in the book, or Johnson's log derivative method
+	int engine = NumerovEngine;
+
+	// how the Bessel functions are computed, see SpecialFunctions::BesselMethod
+	int besselMethod = SpecialFunctions::StableRecurrence;
+
+	// the maximum l when the partial waves are not adaptive, llim in the book
+	// it used to be 8 without USE_BETTER_BESSEL, because of the upward recurrence for j
+	int partialWavesLimit = 11;
+
+	// the largest l allowed for maxPartialWaves and partialWavesLimit, the cross sections are checked to be finite up to it (see tests/LargePartialWaves.cmake)
+	static constexpr int maxPartialWavesAllowed = 1000;
+
+	static const std::vector<Scattering::ScatteringPair> scatteringPairs;
+};
+
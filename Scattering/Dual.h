@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cmath>
+
+namespace Scattering
+{
+
+	// a value together with its derivatives with respect to N variables, for forward mode automatic differentiation
+	// each operation applies the chain rule, so a computation templated on the scalar type gives the exact derivatives of its result in the same pass
+	// (exact for the computation as implemented, that is, for the discretized integration, not for the continuous solution)
+	// constants convert implicitly, comparisons use only the values
+	template<unsigned int N> class Dual
+	{
+	public:
+		Dual(double value = 0) : m_value(value), m_derivatives{} {}
+
+		// the variable with the index, its derivative with respect to itself is 1, the ones with respect to the other variables are 0
+		static Dual Variable(double value, unsigned int index)
+		{
+			Dual res(value);
+			res.m_derivatives[index] = 1;
+
+			return res;
+		}
+
+		// f(x), given the value of f and of its derivative for the value of x
+		static Dual Chain(const Dual& x, double f, double df)
+		{
+			Dual res(f);
+			for (unsigned int i = 0; i < N; ++i)
+				res.m_derivatives[i] = df * x.m_derivatives[i];
+
+			return res;
+		}
+
+		inline double getValue() const { return m_value; }
+		inline double getDerivative(unsigned int index) const { return m_derivatives[index]; }
+
+		Dual operator-() const
+		{
+			return Chain(*this, -m_value, -1.);
+		}
+
+		Dual& operator+=(const Dual& other)
+		{
+			m_value += other.m_value;
+			for (unsigned int i = 0; i < N; ++i)
+				m_derivatives[i] += other.m_derivatives[i];
+
+			return *this;
+		}
+
+		Dual& operator-=(const Dual& other)
+		{
+			m_value -= other.m_value;
+			for (unsigned int i = 0; i < N; ++i)
+				m_derivatives[i] -= other.m_derivatives[i];
+
+			return *this;
+		}
+
+		Dual& operator*=(const Dual& other)
+		{
+			for (unsigned int i = 0; i < N; ++i)
+				m_derivatives[i] = m_derivatives[i] * other.m_value + m_value * other.m_derivatives[i];
+			m_value *= other.m_value;
+
+			return *this;
+		}
+
+		Dual& operator/=(const Dual& other)
+		{
+			const double inv = 1. / other.m_value;
+			m_value *= inv;
+			for (unsigned int i = 0; i < N; ++i)
+				m_derivatives[i] = (m_derivatives[i] - m_value * other.m_derivatives[i]) * inv;
+
+			return *this;
+		}
+
+		// with a constant the derivatives don't need the full product rule
+		Dual& operator+=(double other) { m_value += other; return *this; }
+		Dual& operator-=(double other) { m_value -= other; return *this; }
+
+		Dual& operator*=(double other)
+		{
+			m_value *= other;
+			for (unsigned int i = 0; i < N; ++i)
+				m_derivatives[i] *= other;
+
+			return *this;
+		}
+
+		Dual& operator/=(double other)
+		{
+			m_value /= other;
+			for (unsigned int i = 0; i < N; ++i)
+				m_derivatives[i] /= other;
+
+			return *this;
+		}
+
+		// defined here so the conversion from double works for both operands
+		friend Dual operator+(Dual a, const Dual& b) { return a += b; }
+		friend Dual operator-(Dual a, const Dual& b) { return a -= b; }
+		friend Dual operator*(Dual a, const Dual& b) { return a *= b; }
+		friend Dual operator/(Dual a, const Dual& b) { return a /= b; }
+
+		friend Dual operator+(Dual a, double b) { return a += b; }
+		friend Dual operator+(double a, Dual b) { return b += a; }
+		friend Dual operator-(Dual a, double b) { return a -= b; }
+		friend Dual operator-(double a, const Dual& b) { return Chain(b, a - b.m_value, -1.); }
+		friend Dual operator*(Dual a, double b) { return a *= b; }
+		friend Dual operator*(double a, Dual b) { return b *= a; }
+		friend Dual operator/(Dual a, double b) { return a /= b; }
+
+		friend bool operator<(const Dual& a, const Dual& b) { return a.m_value < b.m_value; }
+		friend bool operator>(const Dual& a, const Dual& b) { return a.m_value > b.m_value; }
+		friend bool operator<=(const Dual& a, const Dual& b) { return a.m_value <= b.m_value; }
+		friend bool operator>=(const Dual& a, const Dual& b) { return a.m_value >= b.m_value; }
+
+		friend Dual sqrt(const Dual& x)
+		{
+			const double s = std::sqrt(x.m_value);
+			return Chain(x, s, 0.5 / s);
+		}
+
+		friend Dual exp(const Dual& x)
+		{
+			const double e = std::exp(x.m_value);
+			return Chain(x, e, e);
+		}
+
+		friend Dual pow(const Dual& x, double p)
+		{
+			const double v = std::pow(x.m_value, p);
+			return Chain(x, v, p * v / x.m_value);
+		}
+
+		friend Dual sin(const Dual& x)
+		{
+			return Chain(x, std::sin(x.m_value), std::cos(x.m_value));
+		}
+
+		friend Dual cos(const Dual& x)
+		{
+			return Chain(x, std::cos(x.m_value), -std::sin(x.m_value));
+		}
+
+		friend Dual atan(const Dual& x)
+		{
+			return Chain(x, std::atan(x.m_value), 1. / (1. + x.m_value * x.m_value));
+		}
+
+	private:
+		double m_value;
+		double m_derivatives[N];
+	};
+
+
+	// the value, for code templated on the scalar type
+	inline double ValueOf(double x) { return x; }
+	template<unsigned int N> inline double ValueOf(const Dual<N>& x) { return x.getValue(); }
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Results.h"
+
+namespace Scattering
+{
+
+	// writes the results of a computation for one or more scattering pairs, as returned by Scattering::Compute
+	// the energies are in meV, the cross sections in rho^2, each line has the maximum partial wave used, too, if available
+	class Export
+	{
+	public:
+		// a block for each pair, starting with a comment line with its name
+		// the blocks are separated by two empty lines, that's what gnuplot expects for the 'index' of a data set
+		static bool WriteText(FILE* file, const std::vector<std::string>& names, const std::vector<Results>& results)
+		{
+			for (size_t p = 0; p < results.size(); ++p)
+			{
+				if (p) fprintf(file, "\n\n");
+
+				fprintf(file, "# %s\n# E (meV)\tsigma (rho^2)\tl\n", names[p].c_str());
+				for (size_t i = 0; i < results[p].size(); ++i)
+					fprintf(file, "%.15g\t%.15g\t%u\n", results[p].energies[i], results[p].crossSections[i], getPartialWave(results[p], i));
+			}
+
+			return 0 == ferror(file);
+		}
+
+		// a line for each energy of each pair, the pair name in the first column
+		static bool WriteCSV(FILE* file, const std::vector<std::string>& names, const std::vector<Results>& results)
+		{
+			fprintf(file, "Pair,E (meV),Cross Section (rho^2),l\n");
+
+			for (size_t p = 0; p < results.size(); ++p)
+				for (size_t i = 0; i < results[p].size(); ++i)
+					fprintf(file, "%s,%.15g,%.15g,%u\n", names[p].c_str(), results[p].energies[i], results[p].crossSections[i], getPartialWave(results[p], i));
+
+			return 0 == ferror(file);
+		}
+
+	private:
+		static unsigned int getPartialWave(const Results& results, size_t i)
+		{
+			return i < results.partialWaves.size() ? results.partialWaves[i] : 0;
+		}
+	};
+
+}
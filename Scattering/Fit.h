@@ -0,0 +1,464 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ComputeContext.h"
+#include "ComputeOptions.h"
+#include "Dual.h"
+#include "Scattering.h"
+#include "ScatteringPair.h"
+
+namespace Scattering
+{
+
+	// a measured total cross section
+	struct Measurement
+	{
+		double energy; // meV
+		double crossSection; // Angstroms^2
+		double error; // the standard deviation of the cross section, 1 if it's not known
+	};
+
+
+	struct FitSettings
+	{
+		bool fitMass = false;
+		unsigned int maxIterations = 100;
+		double tolerance = 1E-6; // stops when the relative change of chi square or of all parameters is smaller
+	};
+
+
+	// fits the potential parameters to measured cross sections, by minimizing chi square with the Levenberg-Marquardt method
+	// the fitted parameters are epsilon and rho and optionally the mass of the second atom
+	// the masses enter only through the reduced mass, fitting both of them would be degenerate
+	// the potential type and the other computation settings are the ones from options
+	class Fit
+	{
+	public:
+		struct Result
+		{
+			ScatteringPair pair; // with the fitted parameters
+			double chiSquare = 0;
+			unsigned int iterations = 0;
+			bool converged = false;
+			bool cancelled = false; // then the parameters are the ones reached so far and there are no errors
+
+			// the standard errors of the parameters, from the covariance matrix scaled with the reduced chi square
+			double epsilonError = 0;
+			double rhoError = 0;
+			double massError = 0;
+		};
+
+		// called after each iteration, with the parameters reached
+		typedef std::function<void(unsigned int iteration, double chiSquare, const ScatteringPair& pair)> Callback;
+
+		// the file has lines with the energy (meV), the cross section (Angstroms^2) and optionally its error, separated by spaces, tabs or commas
+		// the empty lines and the ones starting with # are skipped
+		static bool LoadMeasurements(const std::string& fileName, std::vector<Measurement>& measurements, std::string& error)
+		{
+			measurements.clear();
+
+			std::ifstream file(fileName);
+			if (!file)
+			{
+				error = "Cannot open " + fileName;
+				return false;
+			}
+
+			std::string line;
+			unsigned int lineNumber = 0;
+			while (std::getline(file, line))
+			{
+				++lineNumber;
+
+				std::replace(line.begin(), line.end(), ',', ' ');
+
+				const size_t start = line.find_first_not_of(" \t\r");
+				if (std::string::npos == start || '#' == line[start]) continue;
+
+				std::istringstream stream(line);
+				Measurement measurement{ 0, 0, 1 };
+				if (!(stream >> measurement.energy >> measurement.crossSection) || measurement.energy <= 0)
+				{
+					error = "Invalid measurement at line " + std::to_string(lineNumber) + " in " + fileName;
+					return false;
+				}
+
+				double err;
+				if (stream >> err)
+				{
+					if (err <= 0)
+					{
+						error = "The error must be positive, line " + std::to_string(lineNumber) + " in " + fileName;
+						return false;
+					}
+					measurement.error = err;
+				}
+
+				measurements.push_back(measurement);
+			}
+
+			if (measurements.empty())
+			{
+				error = "No measurements in " + fileName;
+				return false;
+			}
+
+			return true;
+		}
+
+		// only the cancellation of the monitor is used, the points computed while fitting are not passed to it
+		static Result Run(const ComputeOptions& options, const ScatteringPair& start, const std::vector<Measurement>& measurements, ComputeContext& context, const FitSettings& settings = FitSettings(), const Callback& callback = nullptr, const ComputeMonitor* monitor = nullptr)
+		{
+			CancellationMonitor cancellation(monitor);
+			const Model model(options, start, measurements, context, settings.fitMass, cancellation);
+			const size_t nrParams = model.getNrParameters();
+
+			std::vector<double> params = model.getParameters(start);
+			std::vector<double> residuals = model.Residuals(params);
+			double chiSquare = SumOfSquares(residuals);
+
+			Result result;
+			double lambda = 1E-3;
+
+			for (unsigned int iteration = 1; iteration <= settings.maxIterations && !cancellation.isCancelled(); ++iteration)
+			{
+				const std::vector<std::vector<double>> jacobian = model.Jacobian(params);
+
+				std::vector<std::vector<double>> alpha;
+				std::vector<double> beta;
+				NormalEquations(jacobian, residuals, alpha, beta);
+
+				// increase the damping until chi square decreases
+				bool improved = false;
+				double maxChange = 0;
+				const double oldChiSquare = chiSquare;
+
+				while (!improved && lambda < 1E10)
+				{
+					std::vector<std::vector<double>> damped(alpha);
+					for (size_t j = 0; j < nrParams; ++j)
+						damped[j][j] *= 1. + lambda;
+
+					std::vector<double> delta(beta);
+					if (Solve(damped, delta))
+					{
+						std::vector<double> newParams(params);
+						maxChange = 0;
+						for (size_t j = 0; j < nrParams; ++j)
+						{
+							newParams[j] -= delta[j];
+							maxChange = std::max(maxChange, std::abs(delta[j] / params[j]));
+						}
+
+						if (model.isValid(newParams))
+						{
+							std::vector<double> newResiduals = model.Residuals(newParams);
+							const double newChiSquare = SumOfSquares(newResiduals);
+
+							if (newChiSquare < chiSquare)
+							{
+								params.swap(newParams);
+								residuals.swap(newResiduals);
+								chiSquare = newChiSquare;
+								lambda = std::max(lambda * 0.1, 1E-12);
+								improved = true;
+								continue;
+							}
+						}
+					}
+
+					lambda *= 10.;
+				}
+
+				result.iterations = iteration;
+				if (callback) callback(iteration, chiSquare, model.getPair(params));
+
+				// if it cannot be improved anymore, it's at the minimum
+				if (!improved || oldChiSquare - chiSquare <= settings.tolerance * oldChiSquare || maxChange <= settings.tolerance)
+				{
+					result.converged = true;
+					break;
+				}
+			}
+
+			result.pair = model.getPair(params);
+			result.chiSquare = chiSquare;
+
+			// the last values computed might not be complete
+			if (cancellation.isCancelled())
+			{
+				result.converged = false;
+				result.cancelled = true;
+
+				return result;
+			}
+
+			// the covariance matrix is the inverse of alpha, at the minimum
+			const size_t nrMeasurements = measurements.size();
+			if (nrMeasurements > nrParams)
+			{
+				std::vector<std::vector<double>> alpha;
+				std::vector<double> beta;
+				NormalEquations(model.Jacobian(params), residuals, alpha, beta);
+
+				const double scale = chiSquare / (nrMeasurements - nrParams);
+				std::vector<double> errors(nrParams, 0.);
+				for (size_t j = 0; j < nrParams; ++j)
+				{
+					std::vector<std::vector<double>> m(alpha);
+					std::vector<double> unit(nrParams, 0.);
+					unit[j] = 1;
+					if (Solve(m, unit) && unit[j] >= 0) errors[j] = sqrt(unit[j] * scale);
+				}
+
+				result.epsilonError = errors[0];
+				result.rhoError = errors[1];
+				if (settings.fitMass) result.massError = errors[2];
+			}
+
+			return result;
+		}
+
+		// the cross sections in Angstroms^2, for the energies in meV
+		// the monitor is passed to Scattering::ComputeCrossSections, it gets the cross sections in rho^2, not in Angstroms^2
+		static std::vector<double> CrossSections(const ComputeOptions& options, const ScatteringPair& pair, ComputeContext& context, const std::vector<double>& energies, ComputeMonitor* monitor = nullptr)
+		{
+			return Scattering::WithPotential(options, pair, [&](const auto& potential)
+			{
+				std::vector<double> E(energies.size());
+				for (size_t i = 0; i < energies.size(); ++i)
+					E[i] = energies[i] / 27211.386; // meV to Hartrees, see Scattering::Compute
+
+				std::vector<double> crossSections;
+				std::vector<unsigned int> partialWaves;
+				Scattering::ComputeCrossSections(potential, options, context, E, crossSections, partialWaves, nullptr, monitor);
+
+				const double bohr2 = 0.52917721092 * 0.52917721092;
+				for (double& crossSection : crossSections)
+					crossSection *= bohr2;
+
+				return crossSections;
+			});
+		}
+
+	private:
+		// the parameters are epsilon, rho and the mass of the second atom, if fitted, in this order
+		class Model
+		{
+		public:
+			Model(const ComputeOptions& options, const ScatteringPair& pair, const std::vector<Measurement>& measurements, ComputeContext& context, bool fitMass, ComputeMonitor& cancellation)
+				: m_options(options), m_pair(pair), m_measurements(measurements), m_context(context), m_fitMass(fitMass), m_cancellation(cancellation)
+			{
+				for (const Measurement& measurement : measurements)
+					m_energies.push_back(measurement.energy);
+			}
+
+			size_t getNrParameters() const { return m_fitMass ? 3 : 2; }
+
+			std::vector<double> getParameters(const ScatteringPair& pair) const
+			{
+				std::vector<double> params{ pair.epsilon, pair.rho };
+				if (m_fitMass) params.push_back(pair.m2);
+
+				return params;
+			}
+
+			ScatteringPair getPair(const std::vector<double>& params) const
+			{
+				ScatteringPair pair(m_pair);
+				pair.epsilon = params[0];
+				pair.rho = params[1];
+				if (m_fitMass) pair.m2 = params[2];
+
+				return pair;
+			}
+
+			static bool isValid(const std::vector<double>& params)
+			{
+				for (double param : params)
+					if (!(param > 0) || !std::isfinite(param)) return false;
+
+				return true;
+			}
+
+			// (computed - measured) / error
+			std::vector<double> Residuals(const std::vector<double>& params) const
+			{
+				std::vector<double> residuals = CrossSections(m_options, getPair(params), m_context, m_energies, &m_cancellation);
+
+				for (size_t i = 0; i < residuals.size(); ++i)
+					residuals[i] = (residuals[i] - m_measurements[i].crossSection) / m_measurements[i].error;
+
+				return residuals;
+			}
+
+			// the derivatives of the residuals, jacobian[i][j] is for the measurement i and the parameter j
+			// they are computed with automatic differentiation, with the parameters as Dual variables, in a single pass for each energy, the energies are split among the pool threads
+			// the cross sections are computed without the batching for this (see Scattering::CrossSection), with the Numerov engine and the number of steps from options
+			// they agree with the ones used for the residuals except for the last digits, if the options are ones that path follows (see isDifferentiable)
+			// otherwise they are computed with central differences of the residuals, which go through the same computation as everything else
+			std::vector<std::vector<double>> Jacobian(const std::vector<double>& params) const
+			{
+				if (!isDifferentiable(m_options)) return CentralDifferences(params);
+
+				// without the mass there is no need to carry its derivative through the computation
+				if (m_fitMass) return Jacobian<3>(params);
+
+				return Jacobian<2>(params);
+			}
+
+			// Scattering::CrossSection has only the Numerov engine with a fixed number of steps, and its Bessel functions are the ones of the stable recurrence
+			// (or the standard library ones, with USE_BETTER_BESSEL), the upward recurrence ones are wrong for large l, which the derivatives would not follow
+			static bool isDifferentiable(const ComputeOptions& options)
+			{
+				return ComputeOptions::NumerovEngine == options.engine && !options.adaptiveIntegration && SpecialFunctions::UpwardRecurrence != options.besselMethod;
+			}
+
+		private:
+			// all the computations needed are done at once, each of them is a task on the pool, with its energies split further
+			std::vector<std::vector<double>> CentralDifferences(const std::vector<double>& params) const
+			{
+				const size_t nrParams = params.size();
+
+				std::vector<std::vector<double>> residuals(2 * nrParams);
+				std::vector<double> steps(nrParams);
+				for (size_t j = 0; j < nrParams; ++j)
+					steps[j] = 1E-4 * std::abs(params[j]);
+
+				m_context.threadPool.ParallelFor(2 * nrParams, [&](size_t task)
+				{
+					const size_t j = task / 2;
+					std::vector<double> shifted(params);
+					shifted[j] += (task % 2) ? -steps[j] : steps[j];
+
+					residuals[task] = Residuals(shifted);
+				});
+
+				std::vector<std::vector<double>> jacobian(m_measurements.size(), std::vector<double>(nrParams));
+				for (size_t i = 0; i < m_measurements.size(); ++i)
+					for (size_t j = 0; j < nrParams; ++j)
+						jacobian[i][j] = (residuals[2 * j][i] - residuals[2 * j + 1][i]) / (2. * steps[j]);
+
+				return jacobian;
+			}
+
+			template<unsigned int N> std::vector<std::vector<double>> Jacobian(const std::vector<double>& params) const
+			{
+				typedef Dual<N> Variable;
+
+				const size_t nrParams = params.size();
+
+				const Variable epsilon = Variable::Variable(params[0], 0);
+				const Variable rho = Variable::Variable(params[1], 1);
+				const Variable m1(m_pair.m1);
+				Variable m2(m_pair.m2);
+				if constexpr (N > 2) m2 = Variable::Variable(params[2], 2);
+
+				const unsigned int nrSteps = static_cast<unsigned int>(m_options.nrIntegrationSteps);
+				const double bohr2 = 0.52917721092 * 0.52917721092;
+
+				std::vector<std::vector<double>> jacobian(m_measurements.size(), std::vector<double>(nrParams));
+
+				Scattering::WithPotential(m_options, epsilon, rho, m1, m2, [&](const auto& potential)
+				{
+					// the potential with its derivatives is tabulated once, for all energies
+					const PotentialTable<Variable> table = Scattering::getPotentialTable(potential, nrSteps);
+
+					m_context.threadPool.ParallelFor(m_measurements.size(), [&](size_t i)
+					{
+						if (m_cancellation.isCancelled()) return;
+
+						const Variable crossSection = Scattering::CrossSection(potential, table, m_options, Variable(m_energies[i] / 27211.386));
+
+						for (size_t j = 0; j < nrParams; ++j)
+							jacobian[i][j] = crossSection.getDerivative(static_cast<unsigned int>(j)) * bohr2 / m_measurements[i].error;
+					});
+
+					return 0;
+				});
+
+				return jacobian;
+			}
+
+			const ComputeOptions& m_options;
+			const ScatteringPair m_pair;
+			const std::vector<Measurement>& m_measurements;
+			ComputeContext& m_context;
+			const bool m_fitMass;
+			ComputeMonitor& m_cancellation;
+
+			std::vector<double> m_energies;
+		};
+
+		static double SumOfSquares(const std::vector<double>& values)
+		{
+			double sum = 0;
+			for (double value : values)
+				sum += value * value;
+
+			return sum;
+		}
+
+		// alpha = J^T J, beta = J^T r, the step is the solution of alpha delta = beta, subtracted from the parameters
+		static void NormalEquations(const std::vector<std::vector<double>>& jacobian, const std::vector<double>& residuals, std::vector<std::vector<double>>& alpha, std::vector<double>& beta)
+		{
+			const size_t nrParams = jacobian.empty() ? 0 : jacobian[0].size();
+
+			alpha.assign(nrParams, std::vector<double>(nrParams, 0.));
+			beta.assign(nrParams, 0.);
+
+			for (size_t i = 0; i < jacobian.size(); ++i)
+				for (size_t j = 0; j < nrParams; ++j)
+				{
+					beta[j] += jacobian[i][j] * residuals[i];
+					for (size_t k = 0; k < nrParams; ++k)
+						alpha[j][k] += jacobian[i][j] * jacobian[i][k];
+				}
+		}
+
+		// Gauss elimination with partial pivoting, the solution replaces b
+		// there are only two or three parameters, nothing fancier is needed
+		static bool Solve(std::vector<std::vector<double>>& a, std::vector<double>& b)
+		{
+			const size_t n = b.size();
+
+			for (size_t col = 0; col < n; ++col)
+			{
+				size_t pivot = col;
+				for (size_t row = col + 1; row < n; ++row)
+					if (std::abs(a[row][col]) > std::abs(a[pivot][col])) pivot = row;
+
+				if (0 == a[pivot][col] || !std::isfinite(a[pivot][col])) return false;
+
+				std::swap(a[col], a[pivot]);
+				std::swap(b[col], b[pivot]);
+
+				for (size_t row = col + 1; row < n; ++row)
+				{
+					const double factor = a[row][col] / a[col][col];
+					for (size_t k = col; k < n; ++k)
+						a[row][k] -= factor * a[col][k];
+					b[row] -= factor * b[col];
+				}
+			}
+
+			for (size_t col = n; col-- > 0;)
+			{
+				for (size_t k = col + 1; k < n; ++k)
+					b[col] -= a[col][k] * b[k];
+				b[col] /= a[col][col];
+			}
+
+			return true;
+		}
+	};
+
+}
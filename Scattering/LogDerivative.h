@@ -0,0 +1,86 @@
+#pragma once
+
+// the log derivative method is described in
+// The multichannel log-derivative method for scattering calculations
+// by B. R. Johnson
+// Journal of Computational Physics 13, 445 (1973), https://doi.org/10.1016/0021-9991(73)90049-1
+// here it's used for a single channel, so the 'matrices' are just numbers
+
+#include "PotentialGrid.h"
+#include "Simd.h"
+
+namespace Scattering
+{
+
+	// propagates y = u'/u instead of u, for Simd::Lanes energies at once, for the same l, on the tabulated potential grid
+	// u'' = F u is written as u'' + Q u = 0, with Q = -F = 2 m / hbar^2 * E - effective potential
+	// it's stable in the classically forbidden region, where u grows exponentially, and gives the logarithmic derivative directly
+	// instead of getting it from the difference of the values in the last Numerov step
+	// the error is fourth order in h, the integrals of Q are done with the Simpson rule, so the number of intervals must be even, see getSteps
+	class LogDerivativeBatch
+	{
+	public:
+		explicit LogDerivativeBatch(const PotentialGrid& grid) : m_grid(grid) {}
+
+		// the number of steps of the grid for the requested one, rounded up to an even number, at least 2
+		static unsigned int getSteps(unsigned int steps)
+		{
+			return steps < 2 ? 2 : steps + steps % 2;
+		}
+
+		// startValue is u'/u at grid.getStartPoint(), E and y have Simd::Lanes values
+		// the grid must have a number of steps given by getSteps
+		// y is u'/u at the returned position, which is startPoint + steps * h, for the usual grids at maxr, independently of h,
+		// so the phase shifts obtained with different steps can be compared
+		inline double SolveSchrodinger(double startValue, unsigned int l, const double* E, double* y) const
+		{
+			const double h = m_grid.getStep();
+			const double centrifugal = l * (l + 1.);
+			const double* effectivePotential = m_grid.getEffectivePotentials(l);
+
+			double CE[Simd::Lanes];
+			for (size_t i = 0; i < Simd::Lanes; ++i)
+				CE[i] = m_grid.getConstant() * E[i];
+
+			const Simd::Pack constantE = Simd::Pack::Load(CE);
+			const Simd::Pack one(1.);
+			const Simd::Pack hp(h);
+			const Simd::Pack h3(h / 3.);
+			const Simd::Pack h43(4. * h / 3.);
+			const Simd::Pack h23(2. * h / 3.);
+			const Simd::Pack h26(h * h / 6.);
+
+			// the first point has weight 1 in the Simpson rule
+			Simd::Pack Y = Simd::Pack(startValue) - h3 * (constantE - Simd::Pack(m_grid.getStartEffectivePotential(centrifugal)));
+
+			// index 0 is for the first point after start, so the last index is odd
+			const size_t last = m_grid.getSteps() - 1;
+
+			for (size_t i = 0; i < last; ++i)
+			{
+				const Simd::Pack Q = constantE - Simd::Pack(effectivePotential[i]);
+
+				// the free propagation, the solution of y' = -y^2 over the step
+				Y = Y / (one + hp * Y);
+
+				// the odd points (counting from start) have weight 4 and Q is corrected there, the even ones have weight 2
+				if (i % 2 == 0)
+					Y = Y - h43 * Q / (one + h26 * Q);
+				else
+					Y = Y - h23 * Q;
+			}
+
+			// the last point has weight 1, not 2
+			const Simd::Pack Q = constantE - Simd::Pack(effectivePotential[last]);
+			Y = Y / (one + hp * Y) - h3 * Q;
+
+			Y.Store(y);
+
+			return m_grid.getPosition(last);
+		}
+
+	protected:
+		const PotentialGrid& m_grid;
+	};
+
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace Scattering
+{
+
+	// level of detail for plotting a curve with many more points than the pixels it's shown on
+	// each level splits the points in buckets, twice as large as the ones of the level below, and keeps the indices of the points with the minimum and the maximum value in each bucket
+	// drawing those two points for each bucket keeps the shape of the curve, including the narrow peaks of the resonances, which taking every n-th point would miss
+	// the x values must be ascending, as the energies in the results, the arrays are not copied, so they must not change while the pyramid is used
+	class MinMaxPyramid
+	{
+	public:
+		void Build(const double* x, const double* y, size_t size)
+		{
+			m_x = x;
+			m_y = y;
+			m_size = size;
+			m_levels.clear();
+
+			// the points themselves are the level below the first one, a bucket for each
+			size_t nrBuckets = size;
+			while (nrBuckets > 1)
+			{
+				const Level* below = m_levels.empty() ? nullptr : &m_levels.back();
+
+				Level level;
+				level.minIndices.resize((nrBuckets + 1) / 2);
+				level.maxIndices.resize(level.minIndices.size());
+
+				for (size_t b = 0; b < level.minIndices.size(); ++b)
+				{
+					const size_t first = 2 * b;
+					const size_t second = std::min(first + 1, nrBuckets - 1);
+
+					const size_t min1 = below ? below->minIndices[first] : first;
+					const size_t min2 = below ? below->minIndices[second] : second;
+					const size_t max1 = below ? below->maxIndices[first] : first;
+					const size_t max2 = below ? below->maxIndices[second] : second;
+
+					level.minIndices[b] = y[min2] < y[min1] ? min2 : min1;
+					level.maxIndices[b] = y[max2] > y[max1] ? max2 : max1;
+				}
+
+				nrBuckets = level.minIndices.size();
+				m_levels.push_back(std::move(level));
+			}
+		}
+
+		size_t size() const { return m_size; }
+
+		// the indices of the points to draw for x from xMin to xMax, ascending, on the finest level with at most maxBuckets buckets in the range
+		// if there are at most 2 * maxBuckets points in the range, all of them are returned (and nothing is decimated)
+		// the points just outside the range are included, so the line reaches the edges, and so are the first and the last ones in it,
+		// so for the whole range the bounds of the returned points are the ones of the whole curve
+		void Query(double xMin, double xMax, size_t maxBuckets, std::vector<size_t>& indices) const
+		{
+			indices.clear();
+			if (!m_size) return;
+
+			size_t first = std::lower_bound(m_x, m_x + m_size, xMin) - m_x;
+			if (first) --first;
+			size_t last = std::upper_bound(m_x, m_x + m_size, xMax) - m_x;
+			last = std::max(first, std::min(last, m_size - 1));
+
+			maxBuckets = std::max<size_t>(maxBuckets, 1);
+			if (last - first + 1 <= 2 * maxBuckets || m_levels.empty())
+			{
+				for (size_t i = first; i <= last; ++i)
+					indices.push_back(i);
+
+				return;
+			}
+
+			// level k has buckets of 2^(k+1) points
+			size_t k = 0;
+			while (k + 1 < m_levels.size() && (last >> (k + 1)) - (first >> (k + 1)) + 1 > maxBuckets)
+				++k;
+
+			const Level& level = m_levels[k];
+
+			indices.push_back(first);
+			for (size_t b = first >> (k + 1); b <= (last >> (k + 1)); ++b)
+			{
+				indices.push_back(level.minIndices[b]);
+				indices.push_back(level.maxIndices[b]);
+			}
+			indices.push_back(last);
+
+			// the buckets at the ends can have points outside the range, the ones here are sorted and merged with them
+			std::sort(indices.begin(), indices.end());
+			indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+		}
+
+	private:
+		struct Level
+		{
+			std::vector<size_t> minIndices;
+			std::vector<size_t> maxIndices;
+		};
+
+		const double* m_x = nullptr;
+		const double* m_y = nullptr;
+		size_t m_size = 0;
+
+		std::vector<Level> m_levels;
+	};
+
+}
@@ -11,68 +11,92 @@
 // The Journal of Chemical Physics 71, 614 (1979), https://doi.org/10.1063/1.438414
 
 
+#include <cmath>
 #include <tuple>
 #include <limits>
 
 
+#include "Dual.h"
 #include "Potential.h"
+#include "PotentialGrid.h"
+#include "Simd.h"
 
 namespace Scattering
 {
 
-	class Function
+	// PotentialT can be a concrete (final) potential class, then the calls to it are not virtual and the compiler can inline the whole integration step
+	// with the default it works through the virtual calls, for any user defined potential
+	// the computations use the scalar type of the potential, see PotentialT
+	template<class PotentialT = Potential> class Function
 	{
 	public:
-		explicit Function(const Potential& pot) : m_pot(pot) {}
+		typedef typename PotentialT::Scalar Scalar;
+
+		explicit Function(const PotentialT& pot) : m_pot(pot) {}
 
 		// see 2.10 and 2.11, note that 2 m / hbar^2 is not 1, so this is not F, but 2 m / hbar^2 * F
 		// the constant is 2 m / hbar^2, where m is the reduced mass
-		inline double operator()(unsigned int l, double E, double position) const
+		inline Scalar operator()(unsigned int l, const Scalar& E, const Scalar& position) const
+		{
+			return getEffectivePotential(l, position) - m_pot.getConstant() * E;
+		}
+
+		// the part that does not depend on energy
+		inline Scalar getEffectivePotential(unsigned int l, const Scalar& position) const
 		{
-			const double effectivePotential = m_pot.getConstant() * m_pot(position) + l * (l + 1.) / (position * position);
+			return m_pot.getConstant() * m_pot(position) + l * (l + 1.) / (position * position);
+		}
 
-			return  effectivePotential - m_pot.getConstant() * E;
+		inline Scalar getConstant() const
+		{
+			return m_pot.getConstant();
 		}
 
 	protected:
-		const Potential& m_pot;
+		const PotentialT& m_pot;
 	};
 
-	class Numerov
+	template<class PotentialT = Potential> class Numerov
 	{
 	public:
-		explicit Numerov(const Potential& pot) : function(pot) {}
+		typedef typename PotentialT::Scalar Scalar;
 
-		inline std::tuple<double, double, double, double> SolveSchrodinger(double startPoint, double startValue, double nextPoint, double nextValue, unsigned int l, double E, unsigned int steps, double delta) const
+		explicit Numerov(const PotentialT& pot) : function(pot) {}
+
+		// integrates directly with the potential, with its scalar type (see Dual.h)
+		// the cross sections are computed with the tabulated potential instead, see the overloads below and NumerovBatch
+		inline std::tuple<Scalar, Scalar, Scalar, Scalar> SolveSchrodinger(const Scalar& startPoint, const Scalar& startValue, const Scalar& nextPoint, const Scalar& nextValue, unsigned int l, const Scalar& E, unsigned int steps, const Scalar& delta) const
 		{
-			const double h = nextPoint - startPoint;
-			const double h2 = h * h;
+			const Scalar h = nextPoint - startPoint;
+			const Scalar h2 = h * h;
 
-			double wprev = startValue;
-			double w = nextValue;
+			Scalar wprev = startValue;
+			Scalar w = nextValue;
 
-			double position = nextPoint;
-			double funcVal = function(l, E, position);
-			double solution = (1 - h2 / 12. * funcVal) * nextValue;
+			Scalar position = nextPoint;
+			Scalar funcVal = function(l, E, position);
+			Scalar solution = (1. - h2 / 12. * funcVal) * nextValue;
 
 
 			for (unsigned int i = 0; i < steps; ++i)
 			{
-				const double wnext = 2. * w - wprev + h2 * solution * funcVal;
+				const Scalar wnext = 2. * w - wprev + h2 * solution * funcVal;
 				position += h;
 				wprev = w;
 				w = wnext;
 				funcVal = function(l, E, position);
 				solution = getU(w, funcVal, h2);
+
+				if (0 == i % rescaleInterval) Rescale(w, wprev, solution);
 			}
 
-			const double oldpos = position;
-			const double oldsol = solution;
+			const Scalar oldpos = position;
+			const Scalar oldsol = solution;
 
-			const double newLimit = oldpos + delta;
+			const Scalar newLimit = oldpos + delta;
 			do
 			{
-				const double wnext = 2. * w - wprev + h2 * solution * funcVal;
+				const Scalar wnext = 2. * w - wprev + h2 * solution * funcVal;
 				position += h;
 				wprev = w;
 				w = wnext;
@@ -80,22 +104,189 @@ namespace Scattering
 				solution = getU(w, funcVal, h2);
 			} while (position < newLimit);
 
-			return std::tuple<double, double, double, double>(oldpos, oldsol, position, solution);
+			return std::tuple<Scalar, Scalar, Scalar, Scalar>(oldpos, oldsol, position, solution);
 		}
 
-		inline double getValue(unsigned int l, double E, double pos) const
+		inline Scalar getValue(unsigned int l, const Scalar& E, const Scalar& pos) const
 		{
 			return function(l, E, pos);
 		}
 
+		// the same as above, but using the tabulated potential, the grid gives the positions, steps and delta
+		static inline std::tuple<double, double, double, double> SolveSchrodinger(const PotentialGrid& grid, double startValue, double nextValue, unsigned int l, double E)
+		{
+			const double h = grid.getStep();
+			const double h2 = h * h;
+			const double* effectivePotential = grid.getEffectivePotentials(l);
+			const double constantE = grid.getConstant() * E;
+
+			double wprev = startValue;
+			double w = nextValue;
+
+			double funcVal = effectivePotential[0] - constantE;
+			double solution = (1 - h2 / 12. * funcVal) * nextValue;
+
+			const size_t steps = grid.getSteps();
+			const size_t lastStep = steps + grid.getExtraSteps();
+			double oldsol = solution;
+
+			for (size_t i = 1; i <= lastStep; ++i)
+			{
+				const double wnext = 2. * w - wprev + h2 * solution * funcVal;
+				wprev = w;
+				w = wnext;
+				funcVal = effectivePotential[i] - constantE;
+				solution = getU(w, funcVal, h2);
+
+				if (0 == i % rescaleInterval) Rescale(w, wprev, solution, &oldsol);
+				if (i == steps) oldsol = solution;
+			}
+
+			return std::tuple<double, double, double, double>(grid.getOldPosition(), oldsol, grid.getEndPosition(), solution);
+		}
+
+		// the same, with a table for any scalar type, computed for a single energy, see PotentialTable
+		template<typename T> static inline std::tuple<T, T, T, T> SolveSchrodinger(const PotentialTable<T>& table, const T& startValue, const T& nextValue, unsigned int l, const T& E)
+		{
+			const T& h = table.getStep();
+			const T h2 = h * h;
+			const double centrifugal = l * (l + 1.);
+			const T constantE = table.getConstant() * E;
+
+			T wprev = startValue;
+			T w = nextValue;
+
+			T funcVal = table.getEffectivePotential(centrifugal, 0) - constantE;
+			T solution = (1. - h2 / 12. * funcVal) * nextValue;
+
+			const size_t steps = table.getSteps();
+			const size_t lastStep = steps + table.getExtraSteps();
+			T oldsol = solution;
+
+			for (size_t i = 1; i <= lastStep; ++i)
+			{
+				const T wnext = 2. * w - wprev + h2 * solution * funcVal;
+				wprev = w;
+				w = wnext;
+				funcVal = table.getEffectivePotential(centrifugal, i) - constantE;
+				solution = getU(w, funcVal, h2);
+
+				if (0 == i % rescaleInterval) Rescale(w, wprev, solution, &oldsol);
+				if (i == steps) oldsol = solution;
+			}
+
+			return std::tuple<T, T, T, T>(table.getOldPosition(), oldsol, table.getEndPosition(), solution);
+		}
+
+		// the solution is determined up to a factor, only the ratio of the values at the two end positions is used, for the log derivative
+		// for large l it grows very fast in the classically forbidden region under the centrifugal barrier and it would overflow, so it's scaled down when it gets large
+		// checked only every few steps, it's far from overflowing when scaled, even with the fastest growth
+		static constexpr unsigned int rescaleInterval = 8;
+		static constexpr double rescaleLimit = 1E150;
+		static constexpr double rescaleFactor = 1E-150;
+
 	protected:
 		// 2.13
-		static inline double getU(double w, double funcVal, double h2)
+		template<typename T> static inline T getU(const T& w, const T& funcVal, const T& h2)
 		{
 			return w / (1. - h2 / 12. * funcVal);
 		}
 
-		Function function;
+		// oldsol, if not null, is the solution kept from a previous step, it's scaled together with the others
+		template<typename T> static inline void Rescale(T& w, T& wprev, T& solution, T* oldsol = nullptr)
+		{
+			if (std::abs(ValueOf(w)) < rescaleLimit) return;
+
+			w *= rescaleFactor;
+			wprev *= rescaleFactor;
+			solution *= rescaleFactor;
+			if (oldsol) *oldsol *= rescaleFactor;
+		}
+
+		Function<PotentialT> function;
+	};
+
+
+	// integrates Simd::Lanes energies at once, for the same l, on the tabulated potential grid
+	// the lanes are independent, the only thing they share is the energy independent part of the function
+	// the positions depend only on the grid, so they are the same for all lanes, including the end of the final steps that go past delta
+	class NumerovBatch
+	{
+	public:
+		explicit NumerovBatch(const PotentialGrid& grid) : m_grid(grid) {}
+
+		// E, nextValue, u1 and u2 have Simd::Lanes values, u1 is at grid.getOldPosition(), u2 at grid.getEndPosition()
+		// for large l the solution can overflow (see Numerov::Rescale), checking for it in each step would slow down the usual case,
+		// so the lanes are checked at the end and if any overflowed, the batch is integrated again, rescaling as needed
+		inline void SolveSchrodinger(double startValue, const double* nextValue, unsigned int l, const double* E, double* u1, double* u2) const
+		{
+			Integrate<false>(startValue, nextValue, l, E, u1, u2);
+
+			for (size_t lane = 0; lane < Simd::Lanes; ++lane)
+				if (!std::isfinite(u1[lane]) || !std::isfinite(u2[lane]))
+				{
+					Integrate<true>(startValue, nextValue, l, E, u1, u2);
+					break;
+				}
+		}
+
+	private:
+		template<bool rescale> inline void Integrate(double startValue, const double* nextValue, unsigned int l, const double* E, double* u1, double* u2) const
+		{
+			const double h = m_grid.getStep();
+			const double h2 = h * h;
+			const double* effectivePotential = m_grid.getEffectivePotentials(l);
+
+			double CE[Simd::Lanes];
+			for (size_t i = 0; i < Simd::Lanes; ++i)
+				CE[i] = m_grid.getConstant() * E[i];
+
+			const Simd::Pack constantE = Simd::Pack::Load(CE);
+			const Simd::Pack two(2.);
+			const Simd::Pack one(1.);
+			const Simd::Pack h2p(h2);
+			const Simd::Pack h212(h2 / 12.);
+
+			Simd::Pack wprev(startValue);
+			Simd::Pack w = Simd::Pack::Load(nextValue);
+
+			Simd::Pack funcVal = Simd::Pack(effectivePotential[0]) - constantE;
+			Simd::Pack solution = (one - h212 * funcVal) * w;
+			Simd::Pack oldsol = solution;
+
+			const size_t steps = m_grid.getSteps();
+			const size_t lastStep = steps + m_grid.getExtraSteps();
+
+			// see Numerov::Rescale, here each lane is scaled separately
+			const Simd::Pack limit(Numerov<>::rescaleLimit);
+			const Simd::Pack factor(Numerov<>::rescaleFactor);
+
+			for (size_t i = 1; i <= lastStep; ++i)
+			{
+				const Simd::Pack wnext = two * w - wprev + h2p * solution * funcVal;
+				wprev = w;
+				w = wnext;
+				funcVal = Simd::Pack(effectivePotential[i]) - constantE;
+				solution = w / (one - h212 * funcVal); // 2.13
+
+				if (rescale && 0 == i % Numerov<>::rescaleInterval)
+				{
+					const Simd::Pack scale = Simd::Pack::Select(Simd::Pack::Abs(w) > limit, factor, one);
+					w = w * scale;
+					wprev = wprev * scale;
+					solution = solution * scale;
+					oldsol = oldsol * scale;
+				}
+
+				if (i == steps) oldsol = solution;
+			}
+
+			oldsol.Store(u1);
+			solution.Store(u2);
+		}
+
+	protected:
+		const PotentialGrid& m_grid;
 	};
 
 }
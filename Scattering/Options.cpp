@@ -4,13 +4,6 @@
 #include <wx/stdpaths.h> 
 
 
-const std::vector<Scattering::ScatteringPair> Options::scatteringPairs = { 
-	{ "H-Ne", 1.9, 3.15, 1, 20}, {"H-Ar", 4.16, 3.62, 1, 40}, {"H-Kr", 5.9, 3.57, 1, 84}, {"H-Xe", 7.08, 3.82, 1, 131}
-	// with better Bessel functions still does not appear to work correctly for H2, so those will not be available from options
-	, {"H2-Ar", 6.3, 3.57, 2, 40}, {"H2-Kr", 7.19, 3.72, 2, 84}, {"H2-Xe", 8.1, 3.92, 2, 131} 
-};
-
-
 void Options::Open()
 {
 	if (m_fileconfig) return;
@@ -27,6 +20,16 @@ void Options::Open()
 	wxConfigBase::Set(m_fileconfig);
 }
 
+std::string Options::GetCacheDir()
+{
+	wxString dir = wxStandardPaths::Get().GetConfigDir() + wxFileName::GetPathSeparator() + "Cache";
+
+	if (!wxFileName::DirExists(dir) && !wxFileName::Mkdir(dir, 0777, wxPATH_MKDIR_FULL))
+		return std::string();
+
+	return dir.ToStdString();
+}
+
 void Options::Close()
 {
 	delete m_fileconfig;
@@ -43,9 +46,71 @@ void Options::Load()
 		nrPoints = conf->ReadLong("/nrPoints", 1000);
 		scatteringPair = conf->ReadLong("/scatteringPair", 2);
 		nrIntegrationSteps = conf->ReadLong("/nrSteps", 1000);
+		nrThreads = conf->ReadLong("/nrThreads", 0);
+		potentialType = conf->ReadLong("/potentialType", LennardJones126);
+		gamma = conf->ReadDouble("/gamma", 0.5);
+		adaptivePartialWaves = conf->ReadBool("/adaptivePartialWaves", false);
+		maxPartialWaves = conf->ReadLong("/maxPartialWaves", 30);
+		partialWavesTolerance = conf->ReadDouble("/partialWavesTolerance", 1E-5);
+		negligiblePartialWaves = conf->ReadLong("/negligiblePartialWaves", 3);
+		adaptiveEnergyGrid = conf->ReadBool("/adaptiveEnergyGrid", false);
+		energyTolerance = conf->ReadDouble("/energyTolerance", 0.01);
+		maxPhaseShiftChange = conf->ReadDouble("/maxPhaseShiftChange", 0.1);
+		adaptiveIntegration = conf->ReadBool("/adaptiveIntegration", false);
+		phaseShiftAccuracy = conf->ReadDouble("/phaseShiftAccuracy", 1E-3);
+		maxIntegrationSteps = conf->ReadLong("/maxIntegrationSteps", 131072);
+		engine = conf->ReadLong("/engine", NumerovEngine);
+		besselMethod = conf->ReadLong("/besselMethod", SpecialFunctions::StableRecurrence);
+		partialWavesLimit = conf->ReadLong("/partialWavesLimit", 11);
+		batchPairs = conf->ReadLong("/batchPairs", 0xF);
+		diskCache = conf->ReadBool("/diskCache", true);
+		diskCacheSize = conf->ReadLong("/diskCacheSize", 1024);
 
 		if (scatteringPair < 0 || scatteringPair >= scatteringPairs.size())
 			scatteringPair = 2;
+
+		if (nrThreads < 0)
+			nrThreads = 0;
+
+		if (diskCacheSize < 1)
+			diskCacheSize = 1024;
+
+		if (potentialType < LennardJones126 || potentialType > LennardJones1264)
+			potentialType = LennardJones126;
+
+		if (maxPartialWaves < 1 || maxPartialWaves > maxPartialWavesAllowed)
+			maxPartialWaves = 30;
+
+		if (negligiblePartialWaves < 1)
+			negligiblePartialWaves = 3;
+
+		if (energyTolerance <= 0)
+			energyTolerance = 0.01;
+
+		if (maxPhaseShiftChange <= 0)
+			maxPhaseShiftChange = 0.1;
+
+		if (phaseShiftAccuracy <= 0)
+			phaseShiftAccuracy = 1E-3;
+
+		if (maxIntegrationSteps < 64)
+			maxIntegrationSteps = 131072;
+
+		if (engine < NumerovEngine || engine > LogDerivativeEngine)
+			engine = NumerovEngine;
+
+		if (nrIntegrationSteps < (LogDerivativeEngine == engine ? 2 : 1))
+			nrIntegrationSteps = 1000;
+
+		if (besselMethod < SpecialFunctions::StandardLibrary || besselMethod > SpecialFunctions::StableRecurrence)
+			besselMethod = SpecialFunctions::StableRecurrence;
+
+		if (partialWavesLimit < 0 || partialWavesLimit > maxPartialWavesAllowed)
+			partialWavesLimit = 11;
+
+		batchPairs &= (1L << scatteringPairs.size()) - 1;
+		if (0 == batchPairs)
+			batchPairs = 0xF;
 	}
 	Close();
 }
@@ -59,6 +124,25 @@ void Options::Save()
 		conf->Write("/nrPoints", static_cast<long int>(nrPoints));
 		conf->Write("/scatteringPair", scatteringPair);
 		conf->Write("/nrSteps", static_cast<long int>(nrIntegrationSteps));
+		conf->Write("/nrThreads", static_cast<long int>(nrThreads));
+		conf->Write("/potentialType", static_cast<long int>(potentialType));
+		conf->Write("/gamma", gamma);
+		conf->Write("/adaptivePartialWaves", adaptivePartialWaves);
+		conf->Write("/maxPartialWaves", static_cast<long int>(maxPartialWaves));
+		conf->Write("/partialWavesTolerance", partialWavesTolerance);
+		conf->Write("/negligiblePartialWaves", static_cast<long int>(negligiblePartialWaves));
+		conf->Write("/adaptiveEnergyGrid", adaptiveEnergyGrid);
+		conf->Write("/energyTolerance", energyTolerance);
+		conf->Write("/maxPhaseShiftChange", maxPhaseShiftChange);
+		conf->Write("/adaptiveIntegration", adaptiveIntegration);
+		conf->Write("/phaseShiftAccuracy", phaseShiftAccuracy);
+		conf->Write("/maxIntegrationSteps", static_cast<long int>(maxIntegrationSteps));
+		conf->Write("/engine", static_cast<long int>(engine));
+		conf->Write("/besselMethod", static_cast<long int>(besselMethod));
+		conf->Write("/partialWavesLimit", static_cast<long int>(partialWavesLimit));
+		conf->Write("/batchPairs", batchPairs);
+		conf->Write("/diskCache", diskCache);
+		conf->Write("/diskCacheSize", static_cast<long int>(diskCacheSize));
 	}
 
 	if (m_fileconfig)
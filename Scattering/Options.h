@@ -1,15 +1,14 @@
 #pragma once
 
-#include <string>
-#include <vector>
-
 #define wxNEEDS_DECL_BEFORE_TEMPLATE
 
+#include <string>
+
 #include <wx/fileconf.h>
 
-#include "ScatteringPair.h"
+#include "ComputeOptions.h"
 
-class Options
+class Options : public ComputeOptions
 {
 public:
 	Options() = default;
@@ -20,19 +19,16 @@ public:
 
 	// avoid double deletion of m_fileconfig at destruction if copied
 	Options(const Options& other)
-		:
-		nrPoints(other.nrPoints),
-		scatteringPair(other.scatteringPair),
-		nrIntegrationSteps(other.nrIntegrationSteps),
-		m_fileconfig(nullptr)
+		: ComputeOptions(other), batchPairs(other.batchPairs), diskCache(other.diskCache), diskCacheSize(other.diskCacheSize), m_fileconfig(nullptr)
 	{
 	}
 
 	Options& operator=(const Options& other)
 	{
-		nrPoints = other.nrPoints;
-		scatteringPair = other.scatteringPair;
-		nrIntegrationSteps = other.nrIntegrationSteps;
+		ComputeOptions::operator=(other);
+		batchPairs = other.batchPairs;
+		diskCache = other.diskCache;
+		diskCacheSize = other.diskCacheSize;
 		m_fileconfig = nullptr;
 
 		return *this;
@@ -41,11 +37,17 @@ public:
 	void Load();
 	void Save();
 
-	int nrPoints = 1000;
-	int scatteringPair = 2;
-	int nrIntegrationSteps = 1000;
+	// the pairs computed together by the batch calculation, bit i is set for the pair i in scatteringPairs
+	long int batchPairs = 0xF;
+
+	// if set, the computed results are saved in GetCacheDir, so they are loaded instead of computed again after a restart, too
+	bool diskCache = true;
+
+	// in MB, over it the least recently used files in GetCacheDir are deleted
+	int diskCacheSize = 1024;
 
-	static const std::vector<Scattering::ScatteringPair> scatteringPairs;
+	// in the config directory, created if it does not exist, empty if it cannot be created
+	static std::string GetCacheDir();
 
 private:
 	void Open();
@@ -12,11 +12,26 @@
 
 #define ID_NRPOINTS 101
 #define ID_PAIR 102
+#define ID_NRTHREADS 103
+#define ID_POTENTIAL 104
+#define ID_GAMMA 105
+#define ID_ADAPTIVEL 106
+#define ID_MAXL 107
+#define ID_LTOLERANCE 108
+#define ID_ADAPTIVEE 109
+#define ID_ETOLERANCE 110
+#define ID_ADAPTIVEH 111
+#define ID_PHASEACCURACY 112
+#define ID_ENGINE 113
+#define ID_BESSEL 114
+#define ID_LLIM 115
+#define ID_DISKCACHE 116
+#define ID_DISKCACHESIZE 117
 
 wxDECLARE_APP(ScatteringApp);
 
 OptionsFrame::OptionsFrame(const wxString & title, wxWindow* parent)
-	   : wxDialog(parent, wxID_ANY, title, wxDefaultPosition, wxSize(250, 125))
+	   : wxDialog(parent, wxID_ANY, title, wxDefaultPosition, wxSize(300, 315))
 {
 	CreateControls();
 
@@ -67,6 +82,184 @@ void OptionsFrame::CreateControls()
 
 	box->AddSpacer(5);
 
+	// nr threads
+
+	box = new wxBoxSizer(wxHORIZONTAL);
+	boxSizer->Add(box, 0, wxGROW | wxTOP, 5);
+
+	label = new wxStaticText(this, wxID_STATIC, "&Threads:", wxDefaultPosition, wxSize(60, -1), wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
+	box->Add(label, 0, wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL, 5);
+
+	str = wxString::Format(wxT("%i"), options.nrThreads);
+	wxTextCtrl* nrThreadsCtrl = new wxTextCtrl(this, ID_NRTHREADS, str, wxDefaultPosition, wxSize(60, -1), 0);
+	nrThreadsCtrl->SetToolTip("0 uses all the available cores");
+	box->Add(nrThreadsCtrl, 0, wxALIGN_CENTER_VERTICAL, 5);
+
+	box->Add(5, 5, 1, wxALIGN_CENTER_VERTICAL, 5); // pushes to the right
+
+	// integration engine
+
+	label = new wxStaticText(this, wxID_STATIC, "E&ngine:", wxDefaultPosition, wxDefaultSize, wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
+	box->Add(label, 0, wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL, 5);
+
+	// same order as Options::Engine
+	static const wxString engineStrings[] = { "Numerov", "Log deriv." };
+
+	wxChoice* engineChoice = new wxChoice(this, ID_ENGINE, wxDefaultPosition, wxSize(80, -1), WXSIZEOF(engineStrings), engineStrings, 0);
+	engineChoice->SetSelection(options.engine);
+	engineChoice->SetToolTip("Johnson's log derivative method allows much larger steps");
+	box->Add(engineChoice, 0, wxALIGN_CENTER_VERTICAL, 5);
+
+	box->AddSpacer(5);
+
+	// potential
+
+	box = new wxBoxSizer(wxHORIZONTAL);
+	boxSizer->Add(box, 0, wxGROW | wxTOP, 5);
+
+	label = new wxStaticText(this, wxID_STATIC, "P&otential:", wxDefaultPosition, wxSize(60, -1), wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
+	box->Add(label, 0, wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL, 5);
+
+	// same order as Options::PotentialType
+	static const wxString potentialStrings[] = { "LJ 12-6", "LJ 8-6", "LJ 10-6", "LJ 12-6-4" };
+
+	wxChoice* potentialChoice = new wxChoice(this, ID_POTENTIAL, wxDefaultPosition, wxSize(60, -1), WXSIZEOF(potentialStrings), potentialStrings, 0);
+	potentialChoice->SetSelection(options.potentialType);
+	box->Add(potentialChoice, 0, wxALIGN_CENTER_VERTICAL, 5);
+
+	box->Add(5, 5, 1, wxALIGN_CENTER_VERTICAL, 5); // pushes to the right
+
+	label = new wxStaticText(this, wxID_STATIC, "&Gamma:", wxDefaultPosition, wxDefaultSize, wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
+	box->Add(label, 0, wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL, 5);
+
+	str = wxString::Format(wxT("%g"), options.gamma);
+	wxTextCtrl* gammaCtrl = new wxTextCtrl(this, ID_GAMMA, str, wxDefaultPosition, wxSize(60, -1), 0);
+	gammaCtrl->SetToolTip("Used only by the 12-6-4 potential");
+	box->Add(gammaCtrl, 0, wxALIGN_CENTER_VERTICAL, 5);
+
+	box->AddSpacer(5);
+
+	// adaptive partial waves
+
+	box = new wxBoxSizer(wxHORIZONTAL);
+	boxSizer->Add(box, 0, wxGROW | wxTOP, 5);
+
+	wxCheckBox* adaptiveCheck = new wxCheckBox(this, ID_ADAPTIVEL, "&Adaptive l", wxDefaultPosition, wxDefaultSize, 0);
+	adaptiveCheck->SetToolTip("Adds partial waves until they become negligible");
+	box->Add(adaptiveCheck, 0, wxALIGN_CENTER_VERTICAL | wxLEFT, 5);
+
+	box->Add(5, 5, 1, wxALIGN_CENTER_VERTICAL, 5); // pushes to the right
+
+	label = new wxStaticText(this, wxID_STATIC, "&Max l:", wxDefaultPosition, wxDefaultSize, wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
+	box->Add(label, 0, wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL, 5);
+
+	str = wxString::Format(wxT("%i"), options.maxPartialWaves);
+	wxTextCtrl* maxLCtrl = new wxTextCtrl(this, ID_MAXL, str, wxDefaultPosition, wxSize(40, -1), 0);
+	box->Add(maxLCtrl, 0, wxALIGN_CENTER_VERTICAL, 5);
+
+	box->AddSpacer(5);
+
+	label = new wxStaticText(this, wxID_STATIC, "T&ol.:", wxDefaultPosition, wxDefaultSize, wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
+	box->Add(label, 0, wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL, 5);
+
+	str = wxString::Format(wxT("%g"), options.partialWavesTolerance);
+	wxTextCtrl* lToleranceCtrl = new wxTextCtrl(this, ID_LTOLERANCE, str, wxDefaultPosition, wxSize(60, -1), 0);
+	lToleranceCtrl->SetToolTip("Relative to the cross section");
+	box->Add(lToleranceCtrl, 0, wxALIGN_CENTER_VERTICAL, 5);
+
+	box->AddSpacer(5);
+
+	// adaptive energy grid
+
+	box = new wxBoxSizer(wxHORIZONTAL);
+	boxSizer->Add(box, 0, wxGROW | wxTOP, 5);
+
+	wxCheckBox* adaptiveECheck = new wxCheckBox(this, ID_ADAPTIVEE, "Adaptive &E", wxDefaultPosition, wxDefaultSize, 0);
+	adaptiveECheck->SetToolTip("Refines the energy grid where the cross section changes fast, up to the number of points");
+	box->Add(adaptiveECheck, 0, wxALIGN_CENTER_VERTICAL | wxLEFT, 5);
+
+	box->Add(5, 5, 1, wxALIGN_CENTER_VERTICAL, 5); // pushes to the right
+
+	label = new wxStaticText(this, wxID_STATIC, "Tole&rance:", wxDefaultPosition, wxDefaultSize, wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
+	box->Add(label, 0, wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL, 5);
+
+	str = wxString::Format(wxT("%g"), options.energyTolerance);
+	wxTextCtrl* eToleranceCtrl = new wxTextCtrl(this, ID_ETOLERANCE, str, wxDefaultPosition, wxSize(60, -1), 0);
+	eToleranceCtrl->SetToolTip("Relative change of the cross section between neighbour points");
+	box->Add(eToleranceCtrl, 0, wxALIGN_CENTER_VERTICAL, 5);
+
+	box->AddSpacer(5);
+
+	// adaptive integration step
+
+	box = new wxBoxSizer(wxHORIZONTAL);
+	boxSizer->Add(box, 0, wxGROW | wxTOP, 5);
+
+	wxCheckBox* adaptiveHCheck = new wxCheckBox(this, ID_ADAPTIVEH, "Adaptive &h", wxDefaultPosition, wxDefaultSize, 0);
+	adaptiveHCheck->SetToolTip("Chooses the integration step for the requested phase shift accuracy");
+	box->Add(adaptiveHCheck, 0, wxALIGN_CENTER_VERTICAL | wxLEFT, 5);
+
+	box->Add(5, 5, 1, wxALIGN_CENTER_VERTICAL, 5); // pushes to the right
+
+	label = new wxStaticText(this, wxID_STATIC, "A&ccuracy:", wxDefaultPosition, wxDefaultSize, wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
+	box->Add(label, 0, wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL, 5);
+
+	str = wxString::Format(wxT("%g"), options.phaseShiftAccuracy);
+	wxTextCtrl* phaseAccuracyCtrl = new wxTextCtrl(this, ID_PHASEACCURACY, str, wxDefaultPosition, wxSize(60, -1), 0);
+	phaseAccuracyCtrl->SetToolTip("Phase shift accuracy, in radians");
+	box->Add(phaseAccuracyCtrl, 0, wxALIGN_CENTER_VERTICAL, 5);
+
+	box->AddSpacer(5);
+
+	// Bessel functions
+
+	box = new wxBoxSizer(wxHORIZONTAL);
+	boxSizer->Add(box, 0, wxGROW | wxTOP, 5);
+
+	label = new wxStaticText(this, wxID_STATIC, "&Bessel:", wxDefaultPosition, wxSize(60, -1), wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
+	box->Add(label, 0, wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL, 5);
+
+	// same order as SpecialFunctions::BesselMethod
+	static const wxString besselStrings[] = { "Std. library", "Upward", "Stable" };
+
+	wxChoice* besselChoice = new wxChoice(this, ID_BESSEL, wxDefaultPosition, wxSize(90, -1), WXSIZEOF(besselStrings), besselStrings, 0);
+	besselChoice->SetSelection(options.besselMethod);
+	besselChoice->SetToolTip("See Tools->Bessel functions test for a comparison");
+	box->Add(besselChoice, 0, wxALIGN_CENTER_VERTICAL, 5);
+
+	box->Add(5, 5, 1, wxALIGN_CENTER_VERTICAL, 5); // pushes to the right
+
+	label = new wxStaticText(this, wxID_STATIC, "l &lim:", wxDefaultPosition, wxDefaultSize, wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
+	box->Add(label, 0, wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL, 5);
+
+	str = wxString::Format(wxT("%i"), options.partialWavesLimit);
+	wxTextCtrl* lLimCtrl = new wxTextCtrl(this, ID_LLIM, str, wxDefaultPosition, wxSize(40, -1), 0);
+	lLimCtrl->SetToolTip("The maximum l if not adaptive");
+	box->Add(lLimCtrl, 0, wxALIGN_CENTER_VERTICAL, 5);
+
+	box->AddSpacer(5);
+
+	// results cache
+
+	box = new wxBoxSizer(wxHORIZONTAL);
+	boxSizer->Add(box, 0, wxGROW | wxTOP, 5);
+
+	wxCheckBox* diskCacheCheck = new wxCheckBox(this, ID_DISKCACHE, "Cache results on &disk", wxDefaultPosition, wxDefaultSize, 0);
+	diskCacheCheck->SetToolTip("The results are kept in the config directory and loaded instead of computed again, after a restart, too");
+	box->Add(diskCacheCheck, 0, wxALIGN_CENTER_VERTICAL | wxLEFT, 5);
+
+	box->Add(5, 5, 1, wxALIGN_CENTER_VERTICAL, 5); // pushes to the right
+
+	label = new wxStaticText(this, wxID_STATIC, "Si&ze (MB):", wxDefaultPosition, wxDefaultSize, wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
+	box->Add(label, 0, wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL, 5);
+
+	str = wxString::Format(wxT("%i"), options.diskCacheSize);
+	wxTextCtrl* diskCacheSizeCtrl = new wxTextCtrl(this, ID_DISKCACHESIZE, str, wxDefaultPosition, wxSize(60, -1), 0);
+	diskCacheSizeCtrl->SetToolTip("Over it the least recently used results files are deleted, Tools->Clear results cache deletes all of them");
+	box->Add(diskCacheSizeCtrl, 0, wxALIGN_CENTER_VERTICAL, 5);
+
+	box->AddSpacer(5);
+
 	// ******************************************************************
 	// setting validators
 
@@ -78,6 +271,52 @@ void OptionsFrame::CreateControls()
 	
 	scatteringChoice->SetValidator(wxGenericValidator(&options.scatteringPair));
 
+	wxIntegerValidator<int> val2(&options.nrThreads, wxNUM_VAL_DEFAULT);
+	val2.SetRange(0, 1024);
+	nrThreadsCtrl->SetValidator(val2);
+
+	engineChoice->SetValidator(wxGenericValidator(&options.engine));
+
+	potentialChoice->SetValidator(wxGenericValidator(&options.potentialType));
+
+	wxFloatingPointValidator<double> val3(&options.gamma, wxNUM_VAL_DEFAULT);
+	val3.SetRange(0., 1.);
+	gammaCtrl->SetValidator(val3);
+
+	adaptiveCheck->SetValidator(wxGenericValidator(&options.adaptivePartialWaves));
+
+	wxIntegerValidator<int> val4(&options.maxPartialWaves, wxNUM_VAL_DEFAULT);
+	val4.SetRange(1, ComputeOptions::maxPartialWavesAllowed);
+	maxLCtrl->SetValidator(val4);
+
+	wxFloatingPointValidator<double> val5(&options.partialWavesTolerance, wxNUM_VAL_NO_TRAILING_ZEROES);
+	val5.SetRange(0., 1.);
+	lToleranceCtrl->SetValidator(val5);
+
+	adaptiveECheck->SetValidator(wxGenericValidator(&options.adaptiveEnergyGrid));
+
+	wxFloatingPointValidator<double> val6(&options.energyTolerance, wxNUM_VAL_NO_TRAILING_ZEROES);
+	val6.SetRange(0., 1.);
+	eToleranceCtrl->SetValidator(val6);
+
+	adaptiveHCheck->SetValidator(wxGenericValidator(&options.adaptiveIntegration));
+
+	wxFloatingPointValidator<double> val7(&options.phaseShiftAccuracy, wxNUM_VAL_NO_TRAILING_ZEROES);
+	val7.SetRange(0., 1.);
+	phaseAccuracyCtrl->SetValidator(val7);
+
+	besselChoice->SetValidator(wxGenericValidator(&options.besselMethod));
+
+	wxIntegerValidator<int> val8(&options.partialWavesLimit, wxNUM_VAL_DEFAULT);
+	val8.SetRange(0, ComputeOptions::maxPartialWavesAllowed);
+	lLimCtrl->SetValidator(val8);
+
+	diskCacheCheck->SetValidator(wxGenericValidator(&options.diskCache));
+
+	wxIntegerValidator<int> val9(&options.diskCacheSize, wxNUM_VAL_DEFAULT);
+	val9.SetRange(1, 1024 * 1024);
+	diskCacheSizeCtrl->SetValidator(val9);
+
 	// ******************************************************************
 
 	// divider line
@@ -109,12 +348,43 @@ bool OptionsFrame::TransferDataFromWindow()
 	wxString str = nrPointsCtrl->GetValue();
 	long int val = 0;
 	if (!str.ToLong(&val)) return false;
-	if (val < 100 || val > 10000)
+	// the results are decimated for plotting, so the chart is fine with many more points than it has pixels
+	if (val < 1 || val > 10000000)
 	{
-		wxMessageBox("Please enter between 100 and 10000 points", "Validation", wxOK | wxICON_INFORMATION, this);
+		wxMessageBox("Please enter between 1 and 10000000 points", "Validation", wxOK | wxICON_INFORMATION, this);
 
 		return false; 
 	}
+
+	wxTextCtrl* nrThreadsCtrl = (wxTextCtrl*)FindWindow(ID_NRTHREADS);
+	str = nrThreadsCtrl->GetValue();
+	if (!str.ToLong(&val)) return false;
+	if (val < 0 || val > 1024)
+	{
+		wxMessageBox("Please enter between 0 and 1024 threads (0 means all cores)", "Validation", wxOK | wxICON_INFORMATION, this);
+
+		return false;
+	}
+
+	// the validator range includes 0, which would make every interval of the adaptive energy grid be bisected
+	if (options.energyTolerance <= 0)
+	{
+		wxMessageBox("Please enter an energy tolerance greater than 0", "Validation", wxOK | wxICON_INFORMATION, this);
+
+		return false;
+	}
+
+	// the same for the phase shift accuracy, with 0 the adaptive integration would double the steps up to the maximum every time
+	if (options.phaseShiftAccuracy <= 0)
+	{
+		wxMessageBox("Please enter a phase shift accuracy greater than 0", "Validation", wxOK | wxICON_INFORMATION, this);
+
+		return false;
+	}
+
+	// the integration steps are only in the config, the log derivative engine needs at least 2 (see LogDerivativeBatch)
+	if (ComputeOptions::LogDerivativeEngine == options.engine && options.nrIntegrationSteps < 2)
+		options.nrIntegrationSteps = 2;
 	
 	return true;
 }
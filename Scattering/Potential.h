@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cmath>
+
 // the referred formulae are from the book
 // Computational Physics by J M Thijssen
 // isbn: 9780521833462, https://doi.org/10.1017/CBO9781139171397
@@ -13,80 +15,207 @@
 namespace Scattering
 {
 
-	class Potential
+	// T is the scalar type, it can be a Dual (see Dual.h) to get the derivatives of the results with respect to the parameters of the potential
+	template<typename T = double> class PotentialT
 	{
 	public:
-		virtual ~Potential() = default;
-		virtual double operator()(double position) const = 0;
-		virtual double getConstant() const { return 1; }
+		typedef T Scalar;
+
+		virtual ~PotentialT() = default;
+		virtual T operator()(const T& position) const = 0;
+		virtual T getConstant() const { return 1; }
 	};
 
+	typedef PotentialT<double> Potential;
+
 
 	// just an example for another potential, it was used for tests while implementing the code
 	// see the book for details
-	class HarmonicPotential : public Potential
+	class HarmonicPotential final : public Potential
 	{
 	public:
-		double operator()(double position) const override
+		double operator()(const double& position) const override
 		{
 			return position * position;
 		}
 	};
 
 
-	class LennardJonesPotential : public Potential
+	// x^n by repeated squaring, for an exponent known at compile time
+	// much faster than pow with a floating point exponent
+	template<unsigned int n, typename T> constexpr T IntegerPower(const T& x)
+	{
+		if constexpr (0 == n) return 1.;
+		else if constexpr (1 == n) return x;
+		else if constexpr (n % 2) return x * IntegerPower<n - 1>(x);
+		else
+		{
+			const T half = IntegerPower<n / 2>(x);
+			return half * half;
+		}
+	}
+
+
+	// the common part of the Lennard-Jones potentials: units conversions and parameters
+	// for all of them the scalar type is a template parameter, see PotentialT
+	template<typename T> class LennardJonesBase : public PotentialT<T>
 	{
 	public:
 		// pass meV and Angstroms, the atomic mass in Daltons
-		// default parameters for H-Kr
-		LennardJonesPotential(double epsilon = 5.9, double rho = 3.57, double m1 = 1., double m2 = 84.) : m_epsilon(epsilon), m_rho(rho)
+		LennardJonesBase(const T& epsilon, const T& rho, const T& m1, const T& m2) : m_epsilon(epsilon), m_rho(rho)
 		{
 			// use atomic units so hbar is 1
 			m_epsilon /= 1000. * 27.211385; //meV converted to Hartrees
 			m_rho /= 0.52917721092; // Angstroms converted to Bohrs
 
 			// I think the chart in the book uses 1 for this, if a Hydrogen atom and a heavy one are involved it's a good approximation
-			const double reducedMass = m1 * m2 / (m1 + m2);
+			const T reducedMass = m1 * m2 / (m1 + m2);
 
 			// this is 1 / (hbar^2 / (2m)) = 2 m / hbar^2
 			Constant = 2. * reducedMass * 1822.888486192; // also convert the mass to have the electron mass as unit
 		}
 
+		inline const T& getEpsilon() const { return m_epsilon; }
+
+		inline const T& getRho() const { return m_rho; }
+
+		T getConstant() const override { return Constant; }
+
+	protected:
+		// close to the origin the repulsive term A * epsilon * (rho / r)^N dominates
+		// u'' = Constant * A * epsilon * rho^N / r^N * u is solved (for the leading term) by u = exp(-K r^-p) with p = N / 2 - 1 and K = sqrt(Constant * A * epsilon * rho^N) / p
+		// this is eq 2.17 generalized for any even N
+		template<unsigned int N> inline T RepulsiveSolution(double A, const T& r) const
+		{
+			static_assert(N > 2 && 0 == N % 2, "The repulsive exponent must be even and larger than 2");
+
+			constexpr unsigned int p = N / 2 - 1;
+			const T K = sqrt(Constant * A * m_epsilon * IntegerPower<N>(m_rho)) / static_cast<double>(p);
+
+			return exp(-K / IntegerPower<p>(r));
+		}
+
+		// it's just the derivative of the above function
+		template<unsigned int N> inline T RepulsiveDerivative(double A, const T& r) const
+		{
+			constexpr unsigned int p = N / 2 - 1;
+			const T K = sqrt(Constant * A * m_epsilon * IntegerPower<N>(m_rho)) / static_cast<double>(p);
+
+			return K * static_cast<double>(p) / IntegerPower<p + 1>(r) * RepulsiveSolution<N>(A, r);
+		}
+
+		T Constant;
+
+		T m_epsilon;
+		T m_rho;
+	};
+
+
+	template<typename T = double> class LennardJonesPotentialT final : public LennardJonesBase<T>
+	{
+	public:
+		// pass meV and Angstroms, the atomic mass in Daltons
+		// default parameters for H-Kr
+		LennardJonesPotentialT(const T& epsilon = 5.9, const T& rho = 3.57, const T& m1 = 1., const T& m2 = 84.) : LennardJonesBase<T>(epsilon, rho, m1, m2)
+		{
+		}
+
 
-		double operator()(double position) const override
+		T operator()(const T& position) const override
 		{
-			const double rhor = m_rho / position;
+			const T rhor6 = IntegerPower<6>(this->m_rho / position);
 
-			return m_epsilon * (pow(rhor, 12.) - 2. * pow(rhor, 6.));
+			return this->m_epsilon * (rhor6 * rhor6 - 2. * rhor6);
 		}
 
-		inline double SolutionForSmallR(double r) const
+		inline T SolutionForSmallR(const T& r) const
 		{
-			const double C = sqrt(Constant * m_epsilon / 25.);
+			const T C = sqrt(this->Constant * this->m_epsilon / 25.);
 
 			return exp(-C * pow(r, -5)); // see eq 2.17
 		}
 
 		// it's just the derivative of the above function
-		inline double DerivativeForSmallR(double r) const
+		inline T DerivativeForSmallR(const T& r) const
 		{
-			const double C = sqrt(Constant * m_epsilon / 25.);
+			const T C = sqrt(this->Constant * this->m_epsilon / 25.);
 
 			return 5. * C * pow(r, -6) * SolutionForSmallR(r);
 		}
+	};
 
-		inline double getEpsilon() const { return m_epsilon; }
+	typedef LennardJonesPotentialT<double> LennardJonesPotential;
 
-		inline double getRho() const { return m_rho; }
 
-		double getConstant() const override { return Constant; }
+	// the n-m generalization, with the minimum -epsilon at rho:
+	// V = epsilon / (N - M) * (M * (rho / r)^N - N * (rho / r)^M)
+	// for 12-6 it's the same as above, 8-6 and 10-6 are also used in the Toennies et al. paper
+	template<unsigned int N, unsigned int M, typename T = double> class LennardJonesNMPotential final : public LennardJonesBase<T>
+	{
+	public:
+		static_assert(N > M, "The repulsive exponent must be larger than the attractive one");
 
-	private:
-		double Constant;
+		// pass meV and Angstroms, the atomic mass in Daltons
+		LennardJonesNMPotential(const T& epsilon = 5.9, const T& rho = 3.57, const T& m1 = 1., const T& m2 = 84.) : LennardJonesBase<T>(epsilon, rho, m1, m2)
+		{
+		}
+
+		T operator()(const T& position) const override
+		{
+			const T rhor = this->m_rho / position;
+
+			return this->m_epsilon / static_cast<double>(N - M) * (static_cast<double>(M) * IntegerPower<N>(rhor) - static_cast<double>(N) * IntegerPower<M>(rhor));
+		}
+
+		inline T SolutionForSmallR(const T& r) const
+		{
+			return this->template RepulsiveSolution<N>(static_cast<double>(M) / (N - M), r);
+		}
 
-		double m_epsilon;
-		double m_rho;
+		inline T DerivativeForSmallR(const T& r) const
+		{
+			return this->template RepulsiveDerivative<N>(static_cast<double>(M) / (N - M), r);
+		}
 	};
 
+
+	// 12-6-4, with an additional r^-4 attractive term, the weight of the terms is given by gamma
+	// V = epsilon / 2 * ((1 + gamma) * (rho / r)^12 - 4 * gamma * (rho / r)^6 - 3 * (1 - gamma) * (rho / r)^4)
+	// it has the minimum -epsilon at rho for any gamma and it's the 12-6 potential for gamma = 1
+	template<typename T = double> class LennardJones1264PotentialT final : public LennardJonesBase<T>
+	{
+	public:
+		// pass meV and Angstroms, the atomic mass in Daltons
+		LennardJones1264PotentialT(const T& epsilon = 5.9, const T& rho = 3.57, const T& m1 = 1., const T& m2 = 84., double gamma = 0.5) : LennardJonesBase<T>(epsilon, rho, m1, m2), m_gamma(gamma)
+		{
+		}
+
+		T operator()(const T& position) const override
+		{
+			const T rhor2 = IntegerPower<2>(this->m_rho / position);
+			const T rhor4 = rhor2 * rhor2;
+			const T rhor6 = rhor4 * rhor2;
+
+			return 0.5 * this->m_epsilon * ((1. + m_gamma) * rhor6 * rhor6 - 4. * m_gamma * rhor6 - 3. * (1. - m_gamma) * rhor4);
+		}
+
+		inline T SolutionForSmallR(const T& r) const
+		{
+			return this->template RepulsiveSolution<12>(0.5 * (1. + m_gamma), r);
+		}
+
+		inline T DerivativeForSmallR(const T& r) const
+		{
+			return this->template RepulsiveDerivative<12>(0.5 * (1. + m_gamma), r);
+		}
+
+		inline double getGamma() const { return m_gamma; }
+
+	private:
+		double m_gamma;
+	};
+
+	typedef LennardJones1264PotentialT<double> LennardJones1264Potential;
+
 }
 
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Potential.h"
+#include "Simd.h"
+
+namespace Scattering
+{
+
+	// the potential (multiplied by 2 m / hbar^2) and 1 / r^2 tabulated on the integration grid
+	// the grid is the same for all energies and partial waves of a computation, so they are computed only once, instead of at each integration step
+	// the effective potential for each l is also tabulated, the first time it's needed, so the integration for an energy only has to subtract 2 m / hbar^2 * E from it
+	class PotentialGrid
+	{
+	public:
+		// the positions are generated exactly as Numerov::SolveSchrodinger does it, by adding h repeatedly starting from nextPoint:
+		// the first 'steps' positions, then the ones needed to go past 'delta'
+		// the potential type is a template parameter to avoid the virtual calls when the concrete type is known
+		template<class PotentialT> PotentialGrid(const PotentialT& pot, double startPoint, double nextPoint, unsigned int steps, double delta)
+			: m_startPoint(startPoint), m_nextPoint(nextPoint), m_steps(steps), m_constant(pot.getConstant())
+		{
+			const double h = nextPoint - startPoint;
+
+			m_startPotential = m_constant * pot(startPoint);
+			m_startInverseSquare = 1. / (startPoint * startPoint);
+
+			double position = nextPoint;
+			Add(pot, position);
+
+			for (unsigned int i = 0; i < steps; ++i)
+			{
+				position += h;
+				Add(pot, position);
+			}
+
+			m_oldPosition = position;
+
+			const double newLimit = position + delta;
+			do
+			{
+				position += h;
+				Add(pot, position);
+			} while (position < newLimit);
+
+			m_endPosition = position;
+		}
+
+		PotentialGrid(const PotentialGrid&) = delete;
+		PotentialGrid& operator=(const PotentialGrid&) = delete;
+
+		// the effective potential for l, for all the points, index 0 is for nextPoint
+		// it's thread safe, the returned values stay valid as long as the grid exists
+		const double* getEffectivePotentials(unsigned int l) const
+		{
+			std::lock_guard<std::mutex> lock(effectiveMutex);
+
+			if (l >= effectivePotentials.size()) effectivePotentials.resize(l + 1);
+
+			std::unique_ptr<Values>& values = effectivePotentials[l];
+			if (!values)
+			{
+				const double centrifugal = l * (l + 1.);
+
+				values = std::make_unique<Values>(constantPotential.size());
+				for (size_t i = 0; i < constantPotential.size(); ++i)
+					(*values)[i] = constantPotential[i] + centrifugal * inverseSquare[i];
+			}
+
+			return values->data();
+		}
+
+		// the same, at startPoint, which is not in the tables above
+		inline double getStartEffectivePotential(double centrifugal) const
+		{
+			return m_startPotential + centrifugal * m_startInverseSquare;
+		}
+
+		// the position for the index, as accumulated above
+		inline double getPosition(size_t index) const { return positions[index]; }
+
+		inline double getStartPoint() const { return m_startPoint; }
+		inline double getNextPoint() const { return m_nextPoint; }
+		inline double getStep() const { return m_nextPoint - m_startPoint; }
+		inline unsigned int getSteps() const { return m_steps; }
+
+		// the number of points after the first 'steps' ones, the ones that go past delta
+		inline size_t getExtraSteps() const { return constantPotential.size() - m_steps - 1; }
+
+		// the positions where the solution is returned
+		inline double getOldPosition() const { return m_oldPosition; }
+		inline double getEndPosition() const { return m_endPosition; }
+
+		inline double getConstant() const { return m_constant; }
+
+		// in bytes, approximately, including the effective potentials tabulated so far
+		// the ones for l below nrPartialWaves are counted even if they are not tabulated yet, as they will be, for the computations using the grid
+		size_t getMemorySize(unsigned int nrPartialWaves = 0) const
+		{
+			std::lock_guard<std::mutex> lock(effectiveMutex);
+
+			size_t nrValues = constantPotential.size() + inverseSquare.size() + positions.size();
+			nrValues += static_cast<size_t>(nrPartialWaves) * constantPotential.size();
+			for (size_t l = nrPartialWaves; l < effectivePotentials.size(); ++l)
+				if (effectivePotentials[l]) nrValues += effectivePotentials[l]->size();
+
+			return sizeof(PotentialGrid) + nrValues * sizeof(double);
+		}
+
+	protected:
+		typedef std::vector<double, Simd::AlignedAllocator<double>> Values;
+
+		template<class PotentialT> void Add(const PotentialT& pot, double position)
+		{
+			constantPotential.push_back(m_constant * pot(position));
+			inverseSquare.push_back(1. / (position * position));
+			positions.push_back(position);
+		}
+
+		double m_startPoint;
+		double m_nextPoint;
+		unsigned int m_steps;
+		double m_constant;
+
+		double m_oldPosition = 0;
+		double m_endPosition = 0;
+
+		double m_startPotential = 0;
+		double m_startInverseSquare = 0;
+
+		Values constantPotential;
+		Values inverseSquare;
+		std::vector<double> positions;
+
+		mutable std::mutex effectiveMutex;
+		mutable std::vector<std::unique_ptr<Values>> effectivePotentials;
+	};
+
+
+	// the same tabulation, but for any scalar type (see PotentialT), for example Dual, to get the derivatives together with the values
+	// there are no tables per l and no locking, it's meant for a single computation, for all partial waves, see Scattering::CrossSection
+	// the potential is still computed once instead of once for each l
+	template<typename T> class PotentialTable
+	{
+	public:
+		// the positions are generated as in PotentialGrid
+		template<class PotentialT> PotentialTable(const PotentialT& pot, const T& startPoint, const T& nextPoint, unsigned int steps, const T& delta)
+			: m_startPoint(startPoint), m_step(nextPoint - startPoint), m_steps(steps), m_constant(pot.getConstant())
+		{
+			T position = nextPoint;
+			Add(pot, position);
+
+			for (unsigned int i = 0; i < steps; ++i)
+			{
+				position += m_step;
+				Add(pot, position);
+			}
+
+			m_oldPosition = position;
+
+			const T newLimit = position + delta;
+			do
+			{
+				position += m_step;
+				Add(pot, position);
+			} while (position < newLimit);
+
+			m_endPosition = position;
+		}
+
+		// the effective potential for l at the point with the index, index 0 is for nextPoint
+		inline T getEffectivePotential(double centrifugal, size_t index) const
+		{
+			return constantPotential[index] + centrifugal * inverseSquare[index];
+		}
+
+		inline const T& getStartPoint() const { return m_startPoint; }
+		inline const T& getStep() const { return m_step; }
+		inline unsigned int getSteps() const { return m_steps; }
+		inline size_t getExtraSteps() const { return constantPotential.size() - m_steps - 1; }
+
+		inline const T& getOldPosition() const { return m_oldPosition; }
+		inline const T& getEndPosition() const { return m_endPosition; }
+
+		inline const T& getConstant() const { return m_constant; }
+
+	protected:
+		template<class PotentialT> void Add(const PotentialT& pot, const T& position)
+		{
+			constantPotential.push_back(m_constant * pot(position));
+			inverseSquare.push_back(1. / (position * position));
+		}
+
+		T m_startPoint;
+		T m_step;
+		unsigned int m_steps;
+		T m_constant;
+
+		T m_oldPosition;
+		T m_endPosition;
+
+		std::vector<T> constantPotential;
+		std::vector<T> inverseSquare;
+	};
+
+}
@@ -0,0 +1,352 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "ComputeOptions.h"
+#include "Results.h"
+#include "ScatteringPair.h"
+
+namespace Scattering
+{
+
+	// keeps the results of the computations, so computing again with the same pair and options returns them without computing anything
+	// the key has everything that changes the results (see getKey), the number of threads for example is not part of it
+	// if the memory used goes over the limit, the least recently used results are dropped
+	// with a directory set, the results are saved in files there, too, and loaded from there if they are not in memory, so they survive restarts
+	// if the files there take more than the limit for them, the least recently used ones are deleted
+	class ResultCache
+	{
+	public:
+		explicit ResultCache(size_t maxBytes = 64 * 1024 * 1024) : m_maxBytes(maxBytes) {}
+
+		ResultCache(const ResultCache&) = delete;
+		ResultCache& operator=(const ResultCache&) = delete;
+
+		// the options that are not used for the computation with the options set are not in the key
+		// for example the tolerance for partial waves, if they are not adaptive
+		static std::string getKey(const ComputeOptions& options, const ScatteringPair& pair)
+		{
+			char buffer[512];
+
+			std::string key = "v2";
+
+#ifdef USE_BETTER_BESSEL
+			key += " better";
+#endif
+
+			snprintf(buffer, sizeof(buffer), " pair %.17g %.17g %.17g %.17g", pair.epsilon, pair.rho, pair.m1, pair.m2);
+			key += buffer;
+
+			snprintf(buffer, sizeof(buffer), " potential %d", options.potentialType);
+			key += buffer;
+			if (ComputeOptions::LennardJones1264 == options.potentialType)
+			{
+				snprintf(buffer, sizeof(buffer), " %.17g", options.gamma);
+				key += buffer;
+			}
+
+			snprintf(buffer, sizeof(buffer), " engine %d bessel %d", options.engine, options.besselMethod);
+			key += buffer;
+
+			if (options.adaptivePartialWaves)
+				snprintf(buffer, sizeof(buffer), " l adaptive %d %.17g %u", options.maxPartialWaves, options.partialWavesTolerance, options.negligiblePartialWaves);
+			else
+				snprintf(buffer, sizeof(buffer), " l %d", options.partialWavesLimit);
+			key += buffer;
+
+			if (options.adaptiveEnergyGrid)
+				snprintf(buffer, sizeof(buffer), " E adaptive %d %.17g %.17g", options.nrPoints, options.energyTolerance, options.maxPhaseShiftChange);
+			else
+				snprintf(buffer, sizeof(buffer), " E %d", options.nrPoints);
+			key += buffer;
+
+			if (options.adaptiveIntegration)
+				snprintf(buffer, sizeof(buffer), " h adaptive %d %.17g %d", options.nrIntegrationSteps, options.phaseShiftAccuracy, options.maxIntegrationSteps);
+			else
+				snprintf(buffer, sizeof(buffer), " h %d", options.nrIntegrationSteps);
+			key += buffer;
+
+			return key;
+		}
+
+		// returns false if the result is neither in memory nor in the directory
+		bool Get(const std::string& key, Results& result)
+		{
+			std::string directory;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				auto it = m_results.find(key);
+				if (it != m_results.end())
+				{
+					it->second.lastUse = ++m_useCounter;
+					result = it->second.result;
+
+					return true;
+				}
+
+				directory = m_directory;
+			}
+
+			if (directory.empty()) return false;
+
+			const std::string fileName = getFileName(directory, key);
+			if (!Load(fileName, key, result)) return false;
+
+			// the file time is the last use, for pruning
+			std::error_code error;
+			std::filesystem::last_write_time(fileName, std::filesystem::file_time_type::clock::now(), error);
+
+			Add(key, result);
+
+			return true;
+		}
+
+		void Put(const std::string& key, const Results& result)
+		{
+			Add(key, result);
+
+			std::string directory;
+			size_t maxDiskBytes;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				directory = m_directory;
+				maxDiskBytes = m_maxDiskBytes;
+			}
+
+			// failing to save is not an error, the result is just computed again next time
+			if (directory.empty()) return;
+
+			const std::string fileName = getFileName(directory, key);
+			if (Save(fileName, key, result)) Prune(directory, maxDiskBytes, fileName);
+		}
+
+		// an empty directory means no files, it must exist
+		void setDirectory(const std::string& directory, size_t maxDiskBytes = defaultMaxDiskBytes)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_directory = directory;
+			m_maxDiskBytes = maxDiskBytes;
+		}
+
+		// deletes the result files in the directory, the results in memory are kept, see Clear
+		static void RemoveFiles(const std::string& directory)
+		{
+			if (directory.empty()) return;
+
+			std::error_code error;
+			for (const auto& file : std::filesystem::directory_iterator(directory, error))
+				if (isResultFile(file))
+					std::filesystem::remove(file.path(), error);
+		}
+
+		static constexpr size_t defaultMaxDiskBytes = 1024ULL * 1024 * 1024;
+
+		// only the results in memory, the files are kept
+		void Clear()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_results.clear();
+			m_bytes = 0;
+		}
+
+	private:
+		struct Entry
+		{
+			Results result;
+			uint64_t lastUse = 0;
+		};
+
+		static size_t getMemorySize(const std::string& key, const Results& result)
+		{
+			return sizeof(Entry) + key.size() + result.size() * 2 * sizeof(double) + result.partialWaves.size() * sizeof(unsigned int);
+		}
+
+		void Add(const std::string& key, const Results& result)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			Entry& entry = m_results[key];
+			if (entry.lastUse) m_bytes -= getMemorySize(key, entry.result);
+
+			entry.result = result;
+			entry.lastUse = ++m_useCounter;
+			m_bytes += getMemorySize(key, result);
+
+			// the one just added stays, even if it's over the limit by itself
+			while (m_bytes > m_maxBytes && m_results.size() > 1)
+			{
+				auto oldest = m_results.end();
+				for (auto it = m_results.begin(); it != m_results.end(); ++it)
+					if (it->first != key && (oldest == m_results.end() || it->second.lastUse < oldest->second.lastUse))
+						oldest = it;
+
+				m_bytes -= getMemorySize(oldest->first, oldest->second.result);
+				m_results.erase(oldest);
+			}
+		}
+
+		static bool isResultFile(const std::filesystem::directory_entry& file)
+		{
+			std::error_code error;
+
+			return file.is_regular_file(error) && file.path().extension() == ".res";
+		}
+
+		// the least recently used files (by their time, see Get) are deleted until the ones left fit in maxBytes, except the one just saved
+		// another instance can prune the same directory at the same time, deleting a file that's gone already is not an error
+		static void Prune(const std::string& directory, size_t maxBytes, const std::string& keep)
+		{
+			struct File
+			{
+				std::filesystem::path path;
+				std::filesystem::file_time_type time;
+				uintmax_t size;
+			};
+
+			std::vector<File> files;
+			uintmax_t size = 0;
+
+			std::error_code error;
+			for (const auto& file : std::filesystem::directory_iterator(directory, error))
+			{
+				if (!isResultFile(file)) continue;
+
+				std::error_code timeError, sizeError;
+				File info{ file.path(), file.last_write_time(timeError), file.file_size(sizeError) };
+				if (timeError || sizeError) continue;
+
+				size += info.size;
+				files.push_back(std::move(info));
+			}
+
+			if (size <= maxBytes) return;
+
+			std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.time < b.time; });
+
+			const std::filesystem::path keepPath(keep);
+			for (const File& file : files)
+			{
+				if (size <= maxBytes) break;
+				if (file.path.filename() == keepPath.filename()) continue;
+
+				std::filesystem::remove(file.path, error);
+				size -= file.size;
+			}
+		}
+
+		// the key can be long, the file name is its hash (64 bit FNV-1a), the key is saved in the file to check for collisions
+		static std::string getFileName(const std::string& directory, const std::string& key)
+		{
+			uint64_t hash = 14695981039346656037ULL;
+			for (const char c : key)
+			{
+				hash ^= static_cast<unsigned char>(c);
+				hash *= 1099511628211ULL;
+			}
+
+			char buffer[32];
+			snprintf(buffer, sizeof(buffer), "%016llx.res", static_cast<unsigned long long>(hash));
+
+			std::string fileName = directory;
+			if (!fileName.empty() && fileName.back() != '/' && fileName.back() != '\\') fileName += '/';
+
+			return fileName + buffer;
+		}
+
+		// the file has the key, the number of points, then the energies, the cross sections and the partial waves, in binary, as they are in memory, column after column
+		// it's meant to be read back on the same machine only
+		static bool Load(const std::string& fileName, const std::string& key, Results& result)
+		{
+			FILE* file = fopen(fileName.c_str(), "rb");
+			if (!file) return false;
+
+			bool ok = false;
+
+			uint64_t keySize = 0;
+			if (1 == fread(&keySize, sizeof(keySize), 1, file) && keySize == key.size())
+			{
+				std::string fileKey(key.size(), ' ');
+				uint64_t nrPoints = 0;
+				uint64_t nrPartialWaves = 0;
+
+				if (fread(&fileKey[0], 1, key.size(), file) == key.size() && fileKey == key &&
+					1 == fread(&nrPoints, sizeof(nrPoints), 1, file) && 1 == fread(&nrPartialWaves, sizeof(nrPartialWaves), 1, file) &&
+					nrPoints < (1ULL << 32) && nrPartialWaves <= nrPoints)
+				{
+					Results fileResult;
+					fileResult.energies.resize(static_cast<size_t>(nrPoints));
+					fileResult.crossSections.resize(static_cast<size_t>(nrPoints));
+					fileResult.partialWaves.resize(static_cast<size_t>(nrPartialWaves));
+
+					ok = fread(fileResult.energies.data(), sizeof(double), fileResult.energies.size(), file) == fileResult.energies.size() &&
+						fread(fileResult.crossSections.data(), sizeof(double), fileResult.crossSections.size(), file) == fileResult.crossSections.size() &&
+						fread(fileResult.partialWaves.data(), sizeof(unsigned int), fileResult.partialWaves.size(), file) == fileResult.partialWaves.size();
+
+					if (ok) result = std::move(fileResult);
+				}
+			}
+
+			fclose(file);
+
+			return ok;
+		}
+
+		// written in a temporary file first, so a computation reading it at the same time, from another instance, does not see a partial file
+		static bool Save(const std::string& fileName, const std::string& key, const Results& result)
+		{
+			const std::string tempName = fileName + ".tmp";
+
+			FILE* file = fopen(tempName.c_str(), "wb");
+			if (!file) return false;
+
+			const uint64_t keySize = key.size();
+			const uint64_t nrPoints = result.size();
+			const uint64_t nrPartialWaves = result.partialWaves.size();
+
+			bool ok = 1 == fwrite(&keySize, sizeof(keySize), 1, file) &&
+				fwrite(key.data(), 1, key.size(), file) == key.size() &&
+				1 == fwrite(&nrPoints, sizeof(nrPoints), 1, file) &&
+				1 == fwrite(&nrPartialWaves, sizeof(nrPartialWaves), 1, file) &&
+				fwrite(result.energies.data(), sizeof(double), result.energies.size(), file) == result.energies.size() &&
+				fwrite(result.crossSections.data(), sizeof(double), result.crossSections.size(), file) == result.crossSections.size() &&
+				fwrite(result.partialWaves.data(), sizeof(unsigned int), result.partialWaves.size(), file) == result.partialWaves.size();
+
+			ok = 0 == fclose(file) && ok;
+
+			// rename does not replace an existing file on Windows
+			if (ok)
+			{
+				remove(fileName.c_str());
+				ok = 0 == rename(tempName.c_str(), fileName.c_str());
+			}
+
+			if (!ok) remove(tempName.c_str());
+
+			return ok;
+		}
+
+		size_t m_maxBytes;
+		size_t m_bytes = 0;
+
+		std::mutex m_mutex;
+		std::map<std::string, Entry> m_results;
+		uint64_t m_useCounter = 0;
+
+		std::string m_directory;
+		size_t m_maxDiskBytes = defaultMaxDiskBytes;
+	};
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace Scattering
+{
+
+	// the results of the computation for a scattering pair, as returned by Scattering::Compute
+	// the energies are in meV, the cross sections in rho^2, with the maximum l used for each energy
+	// they are kept in columns, not as (energy, cross section) pairs, so each one is a contiguous array
+	// that can be used as it is, for plotting, for example, without copying the values one by one
+	struct Results
+	{
+		std::vector<double> energies;
+		std::vector<double> crossSections;
+		std::vector<unsigned int> partialWaves;
+
+		size_t size() const { return energies.size(); }
+		bool empty() const { return energies.empty(); }
+
+		void clear()
+		{
+			energies.clear();
+			crossSections.clear();
+			partialWaves.clear();
+		}
+	};
+
+}
@@ -13,9 +13,15 @@
 
 #include <algorithm>
 
-#include "Options.h"
+#include "ComputeOptions.h"
 #include "Numerov.h"
+#include "LogDerivative.h"
 #include "SpecialFunctions.h"
+#include "SimdMath.h"
+#include "ComputeContext.h"
+#include "ComputeMonitor.h"
+#include "Results.h"
+#include "Dual.h"
 
 #define _USE_MATH_DEFINES
 //#include <math.h>
@@ -25,6 +31,10 @@
 #include <cmath>
 #endif
 
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace Scattering
@@ -36,8 +46,8 @@ namespace Scattering
 		inline static double PhaseShift(double E, unsigned int l, double r1, double r2, double u1, double u2, double constant)
 		{
 			// 2.9b
-			const double K = r1 * u2 / (r2 * u1);
-			const double k = sqrt(constant * E); // k = sqrt(2mE/hbar^2) where m is the reduced mass, 2m/hbar^2 is the passed constant - see the Lennard-Jones potential to see how it's calculated
+			//const double K = r1 * u2 / (r2 * u1);
+			//const double k = sqrt(constant * E); // k = sqrt(2mE/hbar^2) where m is the reduced mass, 2m/hbar^2 is the passed constant - see the Lennard-Jones potential to see how it's calculated
 
 			// This is the way it's described in the Computational Physics book
 			// it works, but I changed it with using the approximate logarithmic derivative of the wavefunction and derivatives of the Bessel functions, below
@@ -49,11 +59,77 @@ namespace Scattering
 			// this also has another change needed compared with what's described in the book: instead of using Wavelength / 8 (see the commented code in the call for SolveSchrodinger), h is passed
 			// so r2 - r1 = h
 
+			return PhaseShift(E, l, r2, LogDerivative(r1, r2, u1, u2), constant);
+		}
+
+		// R'/R at r2
+		template<typename T> inline static T LogDerivative(const T& r1, const T& r2, const T& u1, const T& u2)
+		{
 			// the -1 / r2 below comes from u = r R
 			// R'/R is needed. If you substitute R = u/r the -1 / r comes out nicely.
 			// R'/R = u'/u - 1/r
-			const double logDeriv = (u2 - u1) / ((r2 - r1) * u2) - 1. / r2; // not a very good approximation, but it seems to work
-			return atan((SpecialFunctions::Bessel::jderiv(l, k * r2) * k - SpecialFunctions::Bessel::j(l, k * r2) * logDeriv) / (SpecialFunctions::Bessel::nderiv(l, k * r2) * k - SpecialFunctions::Bessel::n(l, k * r2) * logDeriv));
+			return (u2 - u1) / ((r2 - r1) * u2) - 1. / r2; // not a very good approximation, but it seems to work
+		}
+
+		// logDeriv is R'/R at r
+		template<typename T> inline static T PhaseShift(const T& E, unsigned int l, const T& r, const T& logDeriv, const T& constant)
+		{
+			const T k = sqrt(constant * E);
+
+			// for large l and small k * r n overflows, the phase shift is 0 there (see BesselTable::isFinite)
+			const T n = SpecialFunctions::Bessel::n(l, k * r);
+			const T nderiv = SpecialFunctions::Bessel::nderiv(l, k * r);
+			if (!std::isfinite(ValueOf(n)) || !std::isfinite(ValueOf(nderiv))) return T(0.);
+
+			return atan((SpecialFunctions::Bessel::jderiv(l, k * r) * k - SpecialFunctions::Bessel::j(l, k * r) * logDeriv) / (nderiv * k - n * logDeriv));
+		}
+
+		// the same as above, but with the Bessel functions taken from the table computed for k * r
+		inline static double PhaseShift(double k, unsigned int l, double logDeriv, const SpecialFunctions::BesselTable& table)
+		{
+			if (!table.isFinite(l)) return 0;
+
+			return atan((table.jderiv(l) * k - table.j(l) * logDeriv) / (table.nderiv(l) * k - table.n(l) * logDeriv));
+		}
+
+		// the batched version of the above and of PartialCrossSection, for Simd::Lanes energies at once, using the SIMD kernels for atan and sin
+		// the Bessel functions for each lane are taken from its table
+		// it agrees with the scalar functions within a few ULP of the phase shifts
+		inline static void PartialCrossSections(const double* E, const double* k, unsigned int l, const double* logDeriv, const SpecialFunctions::BesselTable* tables, double constant, double* shifts, double* crossSections)
+		{
+			double j[Simd::Lanes];
+			double n[Simd::Lanes];
+			double jderiv[Simd::Lanes];
+			double nderiv[Simd::Lanes];
+
+			for (unsigned int lane = 0; lane < Simd::Lanes; ++lane)
+			{
+				if (tables[lane].isFinite(l))
+				{
+					j[lane] = tables[lane].j(l);
+					n[lane] = tables[lane].n(l);
+					jderiv[lane] = tables[lane].jderiv(l);
+					nderiv[lane] = tables[lane].nderiv(l);
+				}
+				else
+				{
+					// these give a phase shift of 0
+					j[lane] = n[lane] = jderiv[lane] = 0;
+					nderiv[lane] = 1;
+				}
+			}
+
+			const Simd::Pack K = Simd::Pack::Load(k);
+			const Simd::Pack L = Simd::Pack::Load(logDeriv);
+
+			const Simd::Pack phaseShift = Simd::Atan((Simd::Pack::Load(jderiv) * K - Simd::Pack::Load(j) * L) / (Simd::Pack::Load(nderiv) * K - Simd::Pack::Load(n) * L));
+			phaseShift.Store(shifts);
+
+			// 2.8
+			const Simd::Pack sdl = Simd::Sin(phaseShift);
+			const Simd::Pack k2 = Simd::Pack(constant) * Simd::Pack::Load(E);
+
+			(Simd::Pack(4. * M_PI) / k2 * Simd::Pack(2. * l + 1.) * sdl * sdl).Store(crossSections);
 		}
 
 		// 2 pi / k, k as above
@@ -64,82 +140,644 @@ namespace Scattering
 
 
 		inline static double PartialCrossSection(double E, double r1, double r2, double u1, double u2, unsigned int l, double constant)
+		{
+			return PartialCrossSection(E, PhaseShift(E, l, r1, r2, u1, u2, constant), l, constant);
+		}
+
+		template<typename T> inline static T PartialCrossSection(const T& E, const T& phaseShift, unsigned int l, const T& constant)
 		{
 			// 2.8
-			const double sdl = sin(PhaseShift(E, l, r1, r2, u1, u2, constant));
-			const double k2 = constant * E; // k^2, k computed as above
+			const T sdl = sin(phaseShift);
+			const T k2 = constant * E; // k^2, k computed as above
 
 			return 4. * M_PI / k2 * (2. * l + 1.) * sdl * sdl;
 		}
 
 	public:
-		static std::vector<std::pair<double, double>> Compute(const Options& options)
+		// calls func with the potential type selected in options, having the parameters of the pair
+		// the type is known at compile time in func, so the calls to the potential can be inlined
+		template<class Func> static auto WithPotential(const ComputeOptions& options, const ScatteringPair& pair, Func&& func)
+		{
+			return WithPotential<double>(options, pair.epsilon, pair.rho, pair.m1, pair.m2, func);
+		}
+
+		// the same, but with the parameters passed with the scalar type T of the potential, for example Dual variables to get the derivatives with respect to them
+		template<typename T, class Func> static auto WithPotential(const ComputeOptions& options, const T& epsilon, const T& rho, const T& m1, const T& m2, Func&& func)
 		{
-			std::vector<std::pair<double, double>> results;
-			results.reserve(options.nrPoints + 1ULL);
+			switch (options.potentialType)
+			{
+			case ComputeOptions::PotentialType::LennardJones86:
+				return func(LennardJonesNMPotential<8, 6, T>(epsilon, rho, m1, m2));
+			case ComputeOptions::PotentialType::LennardJones106:
+				return func(LennardJonesNMPotential<10, 6, T>(epsilon, rho, m1, m2));
+			case ComputeOptions::PotentialType::LennardJones1264:
+				return func(LennardJones1264PotentialT<T>(epsilon, rho, m1, m2, options.gamma));
+			default:
+				break;
+			}
 
+			return func(LennardJonesPotentialT<T>(epsilon, rho, m1, m2));
+		}
 
-			const ScatteringPair& pair = options.scatteringPairs[options.scatteringPair];
-			LennardJonesPotential potential(pair.epsilon, pair.rho, pair.m1, pair.m2);
+		// uses a context just for this computation, with the number of threads from options
+		static Results Compute(const ComputeOptions& options)
+		{
+			ComputeContext context(options.nrThreads > 0 ? static_cast<unsigned int>(options.nrThreads) : 0U);
+
+			return Compute(options, context);
+		}
+
+		// if monitor is not null, it gets the points while they are computed, see ComputeMonitor
+		static Results Compute(const ComputeOptions& options, ComputeContext& context, ComputeMonitor* monitor = nullptr)
+		{
+			return Compute(options, options.scatteringPairs[options.scatteringPair], context, monitor);
+		}
+
+		// for a pair that's not necessarily one of the predefined ones, for example one with fitted parameters
+		// if the same pair was already computed with the same options, the result comes from the cache of the context
+		static Results Compute(const ComputeOptions& options, const ScatteringPair& pair, ComputeContext& context, ComputeMonitor* monitor = nullptr)
+		{
+			const std::string key = ResultCache::getKey(options, pair);
+
+			Results result;
+			if (!context.resultCache.Get(key, result))
+			{
+				result = WithPotential(options, pair, [&](const auto& potential)
+				{
+					return Compute(potential, options, context, monitor);
+				});
+
+				if (!isCancelled(monitor)) context.resultCache.Put(key, result);
+			}
+			else if (monitor && !result.empty())
+			{
+				std::vector<std::pair<double, double>> points(result.size());
+				for (size_t i = 0; i < points.size(); ++i)
+					points[i] = std::make_pair(result.energies[i], result.crossSections[i]);
+
+				monitor->OnPoints(0, points.data(), points.size());
+			}
+
+			return result;
+		}
+
+		// computes the cross sections for more scattering pairs at once, the other options are the same for all
+		// each pair is a task on the pool and its batches of energies are tasks, too, so the threads that finish a pair help with the others
+		// the results are in the order of the pairs
+		static std::vector<Results> Compute(const ComputeOptions& options, const std::vector<int>& pairs, ComputeContext& context, ComputeMonitor* monitor = nullptr)
+		{
+			std::vector<Results> results(pairs.size());
+
+			context.threadPool.ParallelFor(pairs.size(), [&](size_t i)
+			{
+				ComputeOptions pairOptions(options);
+				pairOptions.scatteringPair = pairs[i];
+
+				// the monitor gets the index of the pair with the points
+				std::unique_ptr<PairMonitor> pairMonitor;
+				if (monitor) pairMonitor = std::make_unique<PairMonitor>(*monitor, i);
+
+				results[i] = Compute(pairOptions, context, pairMonitor.get());
+			});
+
+			return results;
+		}
+
+		// the potential type is known at compile time, so the calls to it can be inlined
+		// the columns of the results are the ones used for computing, converted in place
+		template<class PotentialT> static Results Compute(const PotentialT& potential, const ComputeOptions& options, ComputeContext& context, ComputeMonitor* monitor = nullptr)
+		{
+			const double energyMax = getMaxEnergy(potential);
+			const double energyStart = getStartEnergy(potential);
+
+			Results results;
+			std::vector<double>& energies = results.energies;
+			std::vector<double>& crossSections = results.crossSections;
+
+			if (options.adaptiveEnergyGrid)
+				ComputeAdaptiveGrid(potential, options, context, energyStart, energyMax, energies, crossSections, results.partialWaves, monitor);
+			else
+			{
+				const double energyStep = (energyMax - energyStart) / options.nrPoints;
+
+				// the energy grid is indexed, not accumulated, so each point is independent of the others
+				// and the result does not depend on how the points are split among threads
+				energies.resize(options.nrPoints + 1ULL);
+				for (unsigned int i = 0; i < energies.size(); ++i)
+					energies[i] = energyStart + i * energyStep;
+
+				ComputeCrossSections(potential, options, context, energies, crossSections, results.partialWaves, nullptr, monitor);
+			}
+
+			if (isCancelled(monitor)) return Results();
 
 			const double rho = potential.getRho();
 			const double rho2 = rho * rho;
 
-			const double maxr = 5. * rho;
-			const double startR = 0.7 * rho;
-			const double h = (maxr - startR) / options.nrIntegrationSteps; // 100 steps already give 'good' results (for the example in the book), use one order better
-			const double h2 = h * h;
+			for (size_t i = 0; i < energies.size(); ++i)
+			{
+				const std::pair<double, double> point = getResult(energies[i], crossSections[i], rho2);
+				energies[i] = point.first;
+				crossSections[i] = point.second;
+			}
+
+			return results;
+		}
+
+		// computes the cross sections (in atomic units) for the passed energies (in Hartrees), in any order
+		// partialWaves gets the maximum l used for each energy
+		// if phaseShifts is not null, it gets the phase shifts for l from 0 to getMaxPartialWave(options) for each energy, the ones over the used l are left zero
+		// if monitor is not null, it gets the points of each batch of energies when it's done, converted as in the results of Compute
+		template<class PotentialT> static void ComputeCrossSections(const PotentialT& potential, const ComputeOptions& options, ComputeContext& context, const std::vector<double>& energies,
+			std::vector<double>& crossSections, std::vector<unsigned int>& partialWaves, std::vector<double>* phaseShifts = nullptr, ComputeMonitor* monitor = nullptr)
+		{
+			const double rho = potential.getRho();
 
-			const unsigned int steps = static_cast<unsigned int>(ceil((maxr - startR) / h));
+			const double maxr = getMatchingRadius(rho);
+			const double startR = getStartRadius(rho);
 
-			Numerov numerov(potential);
+			const Numerov<PotentialT> numerov(potential);
 
 			const double startVal = potential.SolutionForSmallR(startR);
+			const double startLogDeriv = potential.DerivativeForSmallR(startR) / startVal; // u'/u, for the log derivative engine
+
+			// in the adaptive mode l goes up until the partial cross sections become negligible, but not over the maximum set in options
+			const bool adaptive = options.adaptivePartialWaves;
+			const unsigned int lmax = getMaxPartialWave(options);
+
+			const unsigned int nrEnergies = static_cast<unsigned int>(energies.size());
+			const unsigned int nrPartialWaves = lmax + 1;
+
+			// the partial cross sections are summed up in order at the end
+			// the last l for each energy is kept in partialWaves
+			const unsigned int nrBatches = static_cast<unsigned int>((nrEnergies + Simd::Lanes - 1) / Simd::Lanes);
+			std::vector<double> partialCrossSections(static_cast<size_t>(nrEnergies) * nrPartialWaves);
+			partialWaves.assign(nrEnergies, lmax);
+			if (phaseShifts) phaseShifts->assign(static_cast<size_t>(nrEnergies) * nrPartialWaves, 0.);
+
+			// the potential is tabulated only once for each number of steps, all energies and partial waves integrated with it use the same grid
+			// without adaptive integration there is only one, with nrIntegrationSteps
+			// the grids are kept in the context, so the next computations with the same potential use them, too
+			auto getGrid = [&](unsigned int nrSteps)
+			{
+				return context.gridCache.Get(potential, startR, maxr, nrSteps, nrPartialWaves);
+			};
 
-			const double energyMax = potential.getEpsilon();
-			const double energyStart = energyMax / 20.;
-			const double energyStep = (energyMax - energyStart) / options.nrPoints;
+			// the phase shifts and partial cross sections for the lanes, from R'/R at r
+			// the tables are computed again only for the lanes where k * r changed, with sin and cos computed at once for all of them
+			auto setResults = [&](unsigned int l, const double* E, double r, const double* logDeriv, SpecialFunctions::BesselTable* tables, double* crossSections, double* shifts)
+			{
+				const SpecialFunctions::BesselMethod besselMethod = static_cast<SpecialFunctions::BesselMethod>(options.besselMethod);
 
-#ifdef USE_BETTER_BESSEL
-			const unsigned int llim = 11;
-#else
-			const unsigned int llim = 8;
-#endif
+				double k[Simd::Lanes];
+				Simd::Pack::Sqrt(Simd::Pack(potential.getConstant()) * Simd::Pack::Load(E)).Store(k);
+
+				double x[Simd::Lanes];
+				unsigned int changed[Simd::Lanes];
+				unsigned int nrChanged = 0;
+
+				for (unsigned int lane = 0; lane < Simd::Lanes; ++lane)
+				{
+					const double kr = k[lane] * r;
+					if (tables[lane].getX() != kr)
+					{
+						x[nrChanged] = kr;
+						changed[nrChanged++] = lane;
+					}
+				}
+
+				if (nrChanged)
+				{
+					double s[Simd::Lanes];
+					double c[Simd::Lanes];
+					SpecialFunctions::SinCos(nrChanged, x, s, c);
+
+					for (unsigned int i = 0; i < nrChanged; ++i)
+						tables[changed[i]].Compute(lmax, x[i], s[i], c[i], besselMethod);
+				}
+
+				PartialCrossSections(E, k, l, logDeriv, tables, potential.getConstant(), shifts, crossSections);
+			};
 
-			for (double E = energyStart; E <= energyMax; E += energyStep)
+			// computes the phase shifts and partial cross sections for a batch of energies, at once with NumerovBatch or LogDerivativeBatch
+			// the last batch is padded with the last energy, the padding results must be dropped
+			// the tables keep the Bessel functions for each lane, they are computed again only if k * r changes (the energy or the matching radius)
+			auto computeBatch = [&](unsigned int nrSteps, unsigned int batchStart, unsigned int l, SpecialFunctions::BesselTable* tables, double* crossSections, double* shifts)
 			{
-				double crossSection = 0;
+				if (ComputeOptions::LogDerivativeEngine == options.engine) nrSteps = LogDerivativeBatch::getSteps(nrSteps);
+
+				const std::shared_ptr<const PotentialGrid> gridPtr = getGrid(nrSteps);
+				const PotentialGrid& grid = *gridPtr;
 
-				for (unsigned int l = 0; l <= llim; ++l)
+				double E[Simd::Lanes];
+				for (unsigned int lane = 0; lane < Simd::Lanes; ++lane)
+					E[lane] = energies[std::min(batchStart + lane, nrEnergies - 1)];
+
+				if (ComputeOptions::LogDerivativeEngine == options.engine)
 				{
+					double y[Simd::Lanes];
+					const LogDerivativeBatch logDerivativeBatch(grid);
+					const double r = logDerivativeBatch.SolveSchrodinger(startLogDeriv, l, E, y);
+
+					for (unsigned int lane = 0; lane < Simd::Lanes; ++lane)
+						y[lane] -= 1. / r; // R'/R = u'/u - 1/r
+
+					setResults(l, E, r, y, tables, crossSections, shifts);
+
+					return;
+				}
+
+				const double h = (maxr - startR) / nrSteps;
+				const double h2 = h * h;
+
+				double nextVal[Simd::Lanes];
+				for (unsigned int lane = 0; lane < Simd::Lanes; ++lane)
+				{
+
 					// this works, but it's not a very good approximation, we can do better
 					//const double nextVal = startVal + h * potential.DerivativeForSmallR(startR);
 
 					//see A.54	
 					const double deriv = potential.DerivativeForSmallR(startR);
-					const double h2fminus = h2 * numerov.getValue(l, E, startR - h);
-					const double h2fplus = h2 * numerov.getValue(l, E, startR + h);
-					const double h2f = h2 * numerov.getValue(l, E, startR);
+					const double h2fminus = h2 * numerov.getValue(l, E[lane], startR - h);
+					const double h2fplus = h2 * numerov.getValue(l, E[lane], startR + h);
+					const double h2f = h2 * numerov.getValue(l, E[lane], startR);
 
 					// WARNING: The formula in the book is wrong, you can get the right one from A.52 (substitute w to have it with f and x) and A.53
-					const double nextVal = ((2. + 5. * h2f / 6.) * (1. - h2fminus / 6.) * startVal + 2 * h * deriv * (1. - h2fminus / 12.)) /
+					nextVal[lane] = ((2. + 5. * h2f / 6.) * (1. - h2fminus / 6.) * startVal + 2 * h * deriv * (1. - h2fminus / 12.)) /
 						((1. - h2fplus / 12.) * (1. - h2fminus / 6.) + (1. - h2fminus / 12.) * (1. - h2fplus / 6.));
+				}
+
+				double u1[Simd::Lanes];
+				double u2[Simd::Lanes];
+				const NumerovBatch numerovBatch(grid);
+				numerovBatch.SolveSchrodinger(startVal, nextVal, l, E, u1, u2);
 
-					double r1;
-					double u1;
-					double r2;
-					double u2;
-					// the 'Wavelength' commented code is needed in case of using 2.9a formula in PhaseShift
-					std::tie(r1, u1, r2, u2) = numerov.SolveSchrodinger(startR, startVal, startR + h, nextVal, l, E, steps, h /*Wavelength(E, potential.getConstant()) / 8.*/); // half of wavelength does not seem to be sufficiently small, a quarter is already good
+				const double r1 = grid.getOldPosition();
+				const double r2 = grid.getEndPosition();
 
-					crossSection += PartialCrossSection(E, r1, r2, u1, u2, l, potential.getConstant());
+				double logDeriv[Simd::Lanes];
+				for (unsigned int lane = 0; lane < Simd::Lanes; ++lane)
+					logDeriv[lane] = LogDerivative(r1, r2, u1[lane], u2[lane]);
+
+				setResults(l, E, r2, logDeriv, tables, crossSections, shifts);
+			};
+
+			// with adaptive integration the number of steps is chosen for each batch of energies (they are neighbours, usually) and l:
+			// it starts from an estimate based on the local wavelength, then it's doubled until the phase shifts of all lanes change less than the requested accuracy
+			// the difference is used as the error estimate, for Numerov the finite difference for the logarithmic derivative in PhaseShift makes the convergence only first order in h
+			// the log derivative engine converges much faster, so it stops with fewer steps
+			auto solveBatch = [&](unsigned int batchStart, unsigned int l, SpecialFunctions::BesselTable* tables, double* crossSections, double* shifts)
+			{
+				if (!options.adaptiveIntegration)
+				{
+					computeBatch(static_cast<unsigned int>(options.nrIntegrationSteps), batchStart, l, tables, crossSections, shifts);
+					return;
+				}
+
+				const unsigned int maxSteps = static_cast<unsigned int>(std::max(options.maxIntegrationSteps, options.nrIntegrationSteps));
+				unsigned int nrSteps = getInitialSteps(potential, energies[std::min(batchStart + static_cast<unsigned int>(Simd::Lanes), nrEnergies) - 1], startR, maxr, maxSteps);
+
+				double prevShifts[Simd::Lanes];
+				computeBatch(nrSteps, batchStart, l, tables, crossSections, prevShifts);
+
+				while (nrSteps < maxSteps)
+				{
+					nrSteps = std::min(nrSteps * 2, maxSteps);
+					computeBatch(nrSteps, batchStart, l, tables, crossSections, shifts);
+
+					double error = 0;
+					for (unsigned int lane = 0; lane < Simd::Lanes; ++lane)
+					{
+						error = std::max(error, std::abs(std::remainder(shifts[lane] - prevShifts[lane], M_PI)));
+						prevShifts[lane] = shifts[lane];
+					}
+
+					if (error <= options.phaseShiftAccuracy) return;
 				}
 
-				// convert in units as in the book: meV and rho^2, a Hartree is 27.21138602 eV
-				results.emplace_back(std::make_pair(E * 27211.386, crossSection / rho2));
+				for (unsigned int lane = 0; lane < Simd::Lanes; ++lane)
+					shifts[lane] = prevShifts[lane];
+			};
+
+			auto store = [&](unsigned int i, unsigned int l, double crossSection, double shift)
+			{
+				const size_t index = static_cast<size_t>(i) * nrPartialWaves + l;
+				partialCrossSections[index] = crossSection;
+				if (phaseShifts) (*phaseShifts)[index] = shift;
+			};
+
+			// each batch of energies is a task, l goes in order for it
+			// in the adaptive mode it has to, and this way the Bessel functions tables are computed once for all partial waves
+			context.threadPool.ParallelFor(nrBatches, [&](size_t batch)
+			{
+				const unsigned int batchStart = static_cast<unsigned int>(batch * Simd::Lanes);
+				const unsigned int batchSize = std::min(static_cast<unsigned int>(Simd::Lanes), nrEnergies - batchStart);
+
+				SpecialFunctions::BesselTable tables[Simd::Lanes];
+
+				double crossSection[Simd::Lanes] = {};
+				unsigned int negligible[Simd::Lanes] = {};
+				unsigned int converged = 0;
+
+				for (unsigned int l = 0; l <= lmax && converged < batchSize; ++l)
+				{
+					// the tasks still queued for a cancelled computation return at once
+					if (isCancelled(monitor)) return;
+
+					double crossSections[Simd::Lanes];
+					double shifts[Simd::Lanes];
+					solveBatch(batchStart, l, tables, crossSections, shifts);
+
+					for (unsigned int lane = 0; lane < batchSize; ++lane)
+					{
+						if (negligible[lane] >= options.negligiblePartialWaves) continue; // already converged
+
+						const unsigned int i = batchStart + lane;
+						store(i, l, crossSections[lane], shifts[lane]);
+
+						if (!adaptive) continue;
+
+						crossSection[lane] += crossSections[lane];
+
+						if (crossSections[lane] < options.partialWavesTolerance * crossSection[lane])
+						{
+							if (++negligible[lane] >= options.negligiblePartialWaves)
+							{
+								partialWaves[i] = l;
+								++converged;
+							}
+						}
+						else negligible[lane] = 0;
+					}
+				}
+
+				if (monitor)
+				{
+					// summed in the same order as below, so they are the same as the final results
+					std::pair<double, double> points[Simd::Lanes];
+					for (unsigned int lane = 0; lane < batchSize; ++lane)
+					{
+						const unsigned int i = batchStart + lane;
+
+						double sum = 0;
+						for (unsigned int l = 0; l <= partialWaves[i]; ++l)
+							sum += partialCrossSections[static_cast<size_t>(i) * nrPartialWaves + l];
+
+						points[lane] = getResult(energies[i], sum, rho * rho);
+					}
+
+					monitor->OnPoints(0, points, batchSize);
+				}
+			});
+
+			crossSections.resize(nrEnergies);
+
+			for (unsigned int i = 0; i < nrEnergies; ++i)
+			{
+				double crossSection = 0;
+				for (unsigned int l = 0; l <= partialWaves[i]; ++l)
+					crossSection += partialCrossSections[static_cast<size_t>(i) * nrPartialWaves + l];
+
+				crossSections[i] = crossSection;
 			}
+		}
 
-			return results;
+		// the cross section (in atomic units) for a single energy, without the batching and SIMD used by ComputeCrossSections
+		// it goes the same way as the Numerov engine, with nrSteps, but everything has the scalar type T of the potential
+		// with Dual for T (see Dual.h) it gives the exact derivatives of the cross section with respect to the potential parameters and the energy in the same pass
+		// for that, create them as Dual variables, the potential with WithPotential, for example
+		// if partialWave is not null, it gets the maximum l used
+		template<class PotentialT, typename T = typename PotentialT::Scalar> static T CrossSection(const PotentialT& potential, const ComputeOptions& options, const T& E, unsigned int nrSteps, unsigned int* partialWave = nullptr)
+		{
+			return CrossSection(potential, getPotentialTable(potential, nrSteps), options, E, partialWave);
+		}
+
+		// the tabulated potential for the above, it does not depend on energy, so it can be computed once for more energies
+		template<class PotentialT, typename T = typename PotentialT::Scalar> static PotentialTable<T> getPotentialTable(const PotentialT& potential, unsigned int nrSteps)
+		{
+			const T rho = potential.getRho();
+
+			const T maxr = getMatchingRadius(rho);
+			const T startR = getStartRadius(rho);
+			const T h = (maxr - startR) / static_cast<double>(nrSteps);
+			const unsigned int steps = static_cast<unsigned int>(ceil(ValueOf((maxr - startR) / h)));
+
+			return PotentialTable<T>(potential, startR, startR + h, steps, h);
+		}
+
+		// the same as above, with the table computed for the potential
+		template<class PotentialT, typename T = typename PotentialT::Scalar> static T CrossSection(const PotentialT& potential, const PotentialTable<T>& table, const ComputeOptions& options, const T& E, unsigned int* partialWave = nullptr)
+		{
+			const T& startR = table.getStartPoint();
+			const T& h = table.getStep();
+			const T h2 = h * h;
+
+			const Numerov<PotentialT> numerov(potential);
+
+			const T startVal = potential.SolutionForSmallR(startR);
+			const T deriv = potential.DerivativeForSmallR(startR);
+			const T constant = potential.getConstant();
+
+			const bool adaptive = options.adaptivePartialWaves;
+			const unsigned int lmax = getMaxPartialWave(options);
+
+			T crossSection = 0;
+			unsigned int negligible = 0;
+
+			unsigned int l = 0;
+			for (; l <= lmax; ++l)
+			{
+				// see A.54, as in ComputeCrossSections
+				const T h2fminus = h2 * numerov.getValue(l, E, startR - h);
+				const T h2fplus = h2 * numerov.getValue(l, E, startR + h);
+				const T h2f = h2 * numerov.getValue(l, E, startR);
+
+				const T nextVal = ((2. + 5. * h2f / 6.) * (1. - h2fminus / 6.) * startVal + 2. * h * deriv * (1. - h2fminus / 12.)) /
+					((1. - h2fplus / 12.) * (1. - h2fminus / 6.) + (1. - h2fminus / 12.) * (1. - h2fplus / 6.));
+
+				const auto res = Numerov<PotentialT>::SolveSchrodinger(table, startVal, nextVal, l, E);
+
+				const T r2 = std::get<2>(res);
+				const T phaseShift = PhaseShift(E, l, r2, LogDerivative(std::get<0>(res), r2, std::get<1>(res), std::get<3>(res)), constant);
+				const T partialCrossSection = PartialCrossSection(E, phaseShift, l, constant);
+
+				crossSection += partialCrossSection;
+
+				if (!adaptive) continue;
+
+				if (ValueOf(partialCrossSection) < options.partialWavesTolerance * ValueOf(crossSection))
+				{
+					if (++negligible >= options.negligiblePartialWaves) break;
+				}
+				else negligible = 0;
+			}
+
+			if (partialWave) *partialWave = std::min(l, lmax);
+
+			return crossSection;
+		}
+
+		// the integration goes from the start radius, where the repulsion is so strong that the solution is given by SolutionForSmallR, to the matching radius, where the phase shifts are computed
+		template<typename T> static T getStartRadius(const T& rho) { return 0.7 * rho; }
+		template<typename T> static T getMatchingRadius(const T& rho) { return 5. * rho; }
+
+		// the energy interval, in Hartrees
+		template<class PotentialT> static double getStartEnergy(const PotentialT& potential) { return getMaxEnergy(potential) / 20.; }
+		template<class PotentialT> static double getMaxEnergy(const PotentialT& potential) { return potential.getEpsilon(); }
+
+		// the number of steps for the integration to start with, for adaptive integration
+		// there should be enough points for the fastest oscillation (at the bottom of the potential well)
+		// and for the fastest exponential change (at the start, in the classically forbidden region)
+		// rounded up to a power of two, to share the tabulated potential between as many energies as possible, but not over maxSteps
+		template<class PotentialT> static unsigned int getInitialSteps(const PotentialT& potential, double E, double startR, double maxr, unsigned int maxSteps)
+		{
+			const double constant = potential.getConstant();
+			const double kmax = sqrt(constant * std::max(E + potential.getEpsilon(), std::abs(potential(startR) - E)));
+
+			const unsigned int pointsPerWavelength = 16;
+			const double estimate = (maxr - startR) * kmax / (2. * M_PI) * pointsPerWavelength;
+
+			unsigned int nrSteps = std::min(64U, maxSteps);
+			while (nrSteps < estimate && nrSteps < maxSteps)
+				nrSteps = std::min(nrSteps * 2, maxSteps);
+
+			return nrSteps;
+		}
+
+		static bool isCancelled(const ComputeMonitor* monitor)
+		{
+			return monitor && monitor->isCancelled();
+		}
+
+		// converts to the units of the results, as in the book: meV and rho^2, a Hartree is 27.21138602 eV
+		static std::pair<double, double> getResult(double E, double crossSection, double rho2)
+		{
+			return std::make_pair(E * 27211.386, crossSection / rho2);
+		}
+
+		static unsigned int getMaxPartialWave(const ComputeOptions& options)
+		{
+			if (options.adaptivePartialWaves) return static_cast<unsigned int>(options.maxPartialWaves);
+
+			return static_cast<unsigned int>(options.partialWavesLimit);
+		}
+
+		// the range of the arguments of the Bessel functions for a computation with the options: k * r, with r the matching radius
+		// the matching radius is increased a little, the Numerov engine goes a step past it
+		static void getBesselArgumentRange(const ComputeOptions& options, double& xmin, double& xmax)
+		{
+			const ScatteringPair& pair = options.scatteringPairs[options.scatteringPair];
+			const LennardJonesPotential potential(pair.epsilon, pair.rho, pair.m1, pair.m2); // all Lennard-Jones potentials have the same constant, epsilon and rho
+
+			const double r = getMatchingRadius(potential.getRho());
+			xmin = sqrt(potential.getConstant() * getStartEnergy(potential)) * r;
+			xmax = sqrt(potential.getConstant() * getMaxEnergy(potential)) * r * 1.01;
+		}
+
+	private:
+		// starts with a coarse uniform grid, then bisects the intervals where the cross section or a phase shift changes too much between the ends
+		// until there are no such intervals left or the number of points reaches the one set in options
+		// the intervals where the change is the largest are refined first
+		template<class PotentialT> static void ComputeAdaptiveGrid(const PotentialT& potential, const ComputeOptions& options, ComputeContext& context, double energyStart, double energyMax,
+			std::vector<double>& energies, std::vector<double>& crossSections, std::vector<unsigned int>& partialWaves, ComputeMonitor* monitor = nullptr)
+		{
+			const unsigned int maxPoints = static_cast<unsigned int>(options.nrPoints) + 1;
+			const unsigned int nrPartialWaves = getMaxPartialWave(options) + 1;
+
+			const unsigned int coarseIntervals = std::max(1U, std::min(static_cast<unsigned int>(options.nrPoints), 64U));
+			const double coarseStep = (energyMax - energyStart) / coarseIntervals;
+
+			// don't split intervals smaller than this, a very narrow resonance could eat the whole budget otherwise
+			const double minWidth = (energyMax - energyStart) * 1E-9;
+
+			energies.resize(coarseIntervals + 1ULL);
+			for (unsigned int i = 0; i < energies.size(); ++i)
+				energies[i] = energyStart + i * coarseStep;
+
+			std::vector<double> phaseShifts;
+			ComputeCrossSections(potential, options, context, energies, crossSections, partialWaves, &phaseShifts, monitor);
+
+			while (energies.size() < maxPoints && !isCancelled(monitor))
+			{
+				// how much each interval needs refinement, 1 is the threshold
+				std::vector<std::pair<double, size_t>> refine;
+				for (size_t i = 0; i + 1 < energies.size(); ++i)
+				{
+					if (energies[i + 1] - energies[i] < minWidth) continue;
+
+					const double sigmaScale = std::max(std::abs(crossSections[i]), std::abs(crossSections[i + 1]));
+					double change = sigmaScale > 0 ? std::abs(crossSections[i + 1] - crossSections[i]) / (sigmaScale * options.energyTolerance) : 0;
+
+					// the phase shifts are defined modulo pi
+					const unsigned int lmax = std::min(partialWaves[i], partialWaves[i + 1]);
+					for (unsigned int l = 0; l <= lmax; ++l)
+					{
+						const double delta = std::remainder(phaseShifts[(i + 1) * nrPartialWaves + l] - phaseShifts[i * nrPartialWaves + l], M_PI);
+						change = std::max(change, std::abs(delta) / options.maxPhaseShiftChange);
+					}
+
+					if (change > 1) refine.emplace_back(change, i);
+				}
+
+				if (refine.empty()) break;
+
+				const size_t count = std::min(refine.size(), maxPoints - energies.size());
+				std::partial_sort(refine.begin(), refine.begin() + count, refine.end(), std::greater<std::pair<double, size_t>>());
+				refine.resize(count);
+
+				std::vector<double> newEnergies(count);
+				for (size_t i = 0; i < count; ++i)
+				{
+					const size_t interval = refine[i].second;
+					newEnergies[i] = 0.5 * (energies[interval] + energies[interval + 1]);
+				}
+
+				std::vector<double> newCrossSections;
+				std::vector<unsigned int> newPartialWaves;
+				std::vector<double> newPhaseShifts;
+				ComputeCrossSections(potential, options, context, newEnergies, newCrossSections, newPartialWaves, &newPhaseShifts, monitor);
+
+				// merge the new points, keeping everything sorted by energy
+				std::vector<size_t> order(count);
+				for (size_t i = 0; i < count; ++i) order[i] = i;
+				std::sort(order.begin(), order.end(), [&newEnergies](size_t a, size_t b) { return newEnergies[a] < newEnergies[b]; });
+
+				const size_t total = energies.size() + count;
+				std::vector<double> mergedEnergies;
+				std::vector<double> mergedCrossSections;
+				std::vector<unsigned int> mergedPartialWaves;
+				std::vector<double> mergedPhaseShifts;
+				mergedEnergies.reserve(total);
+				mergedCrossSections.reserve(total);
+				mergedPartialWaves.reserve(total);
+				mergedPhaseShifts.reserve(total * nrPartialWaves);
+
+				auto append = [&](double E, double sigma, unsigned int l, const double* shifts)
+				{
+					mergedEnergies.push_back(E);
+					mergedCrossSections.push_back(sigma);
+					mergedPartialWaves.push_back(l);
+					mergedPhaseShifts.insert(mergedPhaseShifts.end(), shifts, shifts + nrPartialWaves);
+				};
+
+				size_t next = 0;
+				for (size_t i = 0; i < energies.size(); ++i)
+				{
+					for (; next < count && newEnergies[order[next]] < energies[i]; ++next)
+					{
+						const size_t j = order[next];
+						append(newEnergies[j], newCrossSections[j], newPartialWaves[j], &newPhaseShifts[j * nrPartialWaves]);
+					}
+
+					append(energies[i], crossSections[i], partialWaves[i], &phaseShifts[i * nrPartialWaves]);
+				}
+
+				energies.swap(mergedEnergies);
+				crossSections.swap(mergedCrossSections);
+				partialWaves.swap(mergedPartialWaves);
+				phaseShifts.swap(mergedPhaseShifts);
+			}
 		}
 	};
 
@@ -17,11 +17,16 @@
 
 
 #include "ScatteringFrame.h"
+#include "ComputeContext.h"
 
 class ScatteringApp  : public wxApp
 {
 public:
 	ScatteringFrame * frame = nullptr;
 
+	// all computations go through this, the thread pool is resized to the number of threads set in options when a computation starts
+	// it also keeps the tabulated potentials and the results between computations
+	Scattering::ComputeContext computeContext;
+
 	bool OnInit() override;
 };
@@ -1,16 +1,22 @@
+#include "ScatteringApp.h"
 #include "ScatteringFrame.h"
 
 #include "Scattering.h"
+#include "BesselTest.h"
+#include "Export.h"
 
 #include "OptionsFrame.h"
 
 #include "wx/aboutdlg.h"
 #include "wx/statline.h"
 #include "wx/generic/aboutdlgg.h"
+#include "wx/choicdlg.h"
+#include "wx/filedlg.h"
 
 #include <vtkAutoInit.h>
 
-#include <thread>
+#include <algorithm>
+#include <limits>
 
 
 VTK_MODULE_INIT(vtkRenderingOpenGL2);
@@ -21,37 +27,61 @@ VTK_MODULE_INIT(vtkRenderingFreeType);
 #define MY_VTK_WINDOW 102
 
 #define ID_CALCULATE 105
+#define ID_BESSELTEST 106
+#define ID_CALCULATE_BATCH 107
+#define ID_EXPORT 108
+#define ID_FIT 109
+#define ID_CLEARCACHE 110
+
+wxDECLARE_APP(ScatteringApp);
+
+// for the plots of the pairs, the first one is red, as for a single pair
+static const unsigned char plotColors[][3] = { { 255, 0, 0 }, { 0, 0, 255 }, { 0, 160, 0 }, { 255, 128, 0 }, { 160, 0, 160 }, { 0, 160, 160 }, { 96, 96, 96 } };
 
 wxBEGIN_EVENT_TABLE(ScatteringFrame, wxFrame)
 EVT_MENU(ID_CALCULATE, ScatteringFrame::OnCalculate)
-EVT_UPDATE_UI(ID_CALCULATE, ScatteringFrame::OnUpdateCalculate)
+EVT_MENU(ID_CALCULATE_BATCH, ScatteringFrame::OnCalculateBatch)
+EVT_MENU(ID_EXPORT, ScatteringFrame::OnExport)
+EVT_UPDATE_UI(ID_EXPORT, ScatteringFrame::OnUpdateExport)
 EVT_MENU(wxID_EXIT, ScatteringFrame::OnExit)
 EVT_MENU(wxID_PREFERENCES, ScatteringFrame::OnOptions)
 EVT_MENU(wxID_ABOUT, ScatteringFrame::OnAbout)
-EVT_TIMER(101, ScatteringFrame::OnTimer)
+EVT_MENU(ID_BESSELTEST, ScatteringFrame::OnBesselTest)
+EVT_MENU(ID_FIT, ScatteringFrame::OnFit)
+EVT_MENU(ID_CLEARCACHE, ScatteringFrame::OnClearCache)
 EVT_ERASE_BACKGROUND(ScatteringFrame::OnEraseBackground)
+EVT_CLOSE(ScatteringFrame::OnClose)
 wxEND_EVENT_TABLE()
 
 
 ScatteringFrame::ScatteringFrame(const wxString& title, const wxPoint& pos, const wxSize& size)
-	: wxFrame(NULL, wxID_ANY, title, pos, size),
-	timer(this, 101)
+	: wxFrame(NULL, wxID_ANY, title, pos, size)
 {
 	wxMenu *menuFile = new wxMenu;
 
 	menuFile->Append(ID_CALCULATE, "C&alculate\tCtrl+a", "Starts computing");
+	menuFile->Append(ID_CALCULATE_BATCH, "Calculate &batch...\tCtrl+b", "Computes more scattering pairs at once");
+	menuFile->Append(wxID_SEPARATOR);
+	menuFile->Append(ID_EXPORT, "&Export...\tCtrl+e", "Saves the results in a file");
 	menuFile->Append(wxID_SEPARATOR);
 	menuFile->Append(wxID_EXIT);
 
 	wxMenu *menuView = new wxMenu;
 	menuView->Append(wxID_PREFERENCES);
 
+	wxMenu *menuTools = new wxMenu;
+	menuTools->Append(ID_BESSELTEST, "&Bessel functions test", "Compares the Bessel functions implementations for the current options");
+	menuTools->Append(ID_FIT, "&Fit to measurements...", "Fits epsilon and rho of the current pair to measured cross sections");
+	menuTools->Append(wxID_SEPARATOR);
+	menuTools->Append(ID_CLEARCACHE, "&Clear results cache", "Drops the cached results, from memory and from disk");
+
 	wxMenu *menuHelp = new wxMenu;
 	menuHelp->Append(wxID_ABOUT);
 
 	wxMenuBar *menuBar = new wxMenuBar;
 	menuBar->Append(menuFile, "&File");
 	menuBar->Append(menuView, "&View");
+	menuBar->Append(menuTools, "&Tools");
 	menuBar->Append(menuHelp, "&Help");
 
 	SetMenuBar(menuBar);
@@ -66,8 +96,7 @@ ScatteringFrame::ScatteringFrame(const wxString& title, const wxPoint& pos, cons
 
 	ConstructVTK();
 
-	std::vector<std::pair<double, double>> empty_results;
-	ConfigureVTK("", empty_results);
+	ConfigureVTK(std::vector<std::string>());
 	
 	currentOptions.Load();
 }
@@ -92,6 +121,9 @@ void ScatteringFrame::ConstructVTK()
 	pChart = vtkChartXY::New();
 	pChart->SetRenderEmpty(true);		
 	pContextView->GetScene()->AddItem(pChart);
+
+	// zooming or panning changes the range, the plots of the results are refined for it
+	pChart->GetAxis(vtkAxis::BOTTOM)->AddObserver(vtkChart::UpdateRange, this, &ScatteringFrame::OnEnergyRangeChanged);
 }
 
 void ScatteringFrame::DestroyVTK()
@@ -104,70 +136,292 @@ void ScatteringFrame::DestroyVTK()
 
 void ScatteringFrame::OnCalculate(wxCommandEvent& /*event*/)
 {
-	Compute();
+	// the running fit uses the measurements, it must end before they change
+	CancelComputation();
+
+	measurements.clear();
+	Compute(std::vector<int>{ currentOptions.scatteringPair });
 }
 
-void ScatteringFrame::OnUpdateCalculate(wxUpdateUIEvent& event)
+void ScatteringFrame::OnCalculateBatch(wxCommandEvent& /*event*/)
 {
-	event.Enable(isFinished());
+	wxArrayString choices;
+	wxArrayInt selections;
+	for (size_t i = 0; i < Options::scatteringPairs.size(); ++i)
+	{
+		choices.Add(Options::scatteringPairs[i].pairName);
+		if (currentOptions.batchPairs & (1L << i)) selections.Add(static_cast<int>(i));
+	}
+
+	wxMultiChoiceDialog dialog(this, "Scattering pairs to compute, with the current options:", "Batch calculation", choices);
+	dialog.SetSelections(selections);
+	if (wxID_OK != dialog.ShowModal()) return;
+
+	selections = dialog.GetSelections();
+	if (selections.IsEmpty()) return;
+
+	std::vector<int> pairs;
+	currentOptions.batchPairs = 0;
+	for (int selection : selections)
+	{
+		pairs.push_back(selection);
+		currentOptions.batchPairs |= 1L << selection;
+	}
+	currentOptions.Save();
+
+	CancelComputation();
+
+	measurements.clear();
+	Compute(pairs);
 }
 
 
-void ScatteringFrame::ConfigureVTK(const std::string& name, const std::vector<std::pair<double, double>>& results)
+// clears the chart, for the plots of the pairs with the names
+void ScatteringFrame::ConfigureVTK(const std::vector<std::string>& names)
 {
 	pChart->ClearPlots();
+	resultsTables.clear();
+	pyramids.clear();
 
-	if (name.empty()) pChart->SetTitle("Scattering Cross Section");
+	if (1 != names.size()) pChart->SetTitle("Scattering Cross Section");
 	else
 	{
-		std::string Name = name;
+		std::string Name = names.front();
 		Name += " Scattering Cross Section";
 		pChart->SetTitle(Name.c_str());
 	}
 
+	// with more pairs the plots are overlaid, the legend tells which is which
+	pChart->SetShowLegend(names.size() > 1);
 
 	pChart->SetAutoAxes(false);
 
 	pChart->GetAxis(vtkAxis::BOTTOM)->SetTitle("Energy (meV)");
 	pChart->GetAxis(vtkAxis::LEFT)->SetTitle("Cross Section (rho^2)");
+}
+
+// a line for each pair, with the points from UpdateResultsPlots
+// the pyramids for them are built here, once, they use the columns of the results, so the results must not change while the plots are there
+void ScatteringFrame::AddResultsPlots(const std::vector<std::string>& names)
+{
+	for (size_t p = 0; p < results.size() && p < names.size(); ++p)
+	{
+		if (results[p].empty()) continue;
+
+		pyramids.emplace_back();
+		pyramids.back().Build(results[p].energies.data(), results[p].crossSections.data(), results[p].size());
+
+
+		// set up the data table
+
+		vtkNew<vtkTable> table;
+
+		vtkNew<vtkDoubleArray> arrX;
+		arrX->SetName("X");
+		table->AddColumn(arrX.GetPointer());
+
+		vtkNew<vtkDoubleArray> arrC;
+		arrC->SetName(names[p].c_str()); // shown in the legend
+		table->AddColumn(arrC.GetPointer());
+
+		resultsTables.push_back(table.GetPointer());
+
+
+		// add the line to the chart
+
+		vtkPlot *line = pChart->AddPlot(vtkChart::LINE);
+		// Use columns 0 and 1 for x and y
+		line->SetInputData(table.GetPointer(), 0, 1);
+
+		// a width of 2.0 pixels
+		const unsigned char* color = plotColors[p % WXSIZEOF(plotColors)];
+		line->SetColor(color[0], color[1], color[2], 255);
+		line->SetWidth(2.0);
+	}
+
+	// everything, the chart sets the range from the bounds of the points, which are the ones of all the results
+	UpdateResultsPlots(-std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+}
+
+// with millions of points the line plots are slow to draw, so the chart gets about two points for each pixel of the energy range shown:
+// the minimum and the maximum of the cross section in the energies of the pixel (see MinMaxPyramid), the resonance peaks are not lost this way
+// zoomed in enough, all the points are shown, then the arrays of the tables are the part of the columns of the results that's shown, not copies
+// vtk does not free them (the last parameter of SetArray)
+void ScatteringFrame::UpdateResultsPlots(double xMin, double xMax)
+{
+	plottedMin = xMin;
+	plottedMax = xMax;
 
-	if (results.empty()) return;
+	const size_t maxBuckets = static_cast<size_t>(std::max(m_pVTKWindow ? m_pVTKWindow->GetClientSize().GetWidth() : 0, 512));
 
-	int numPoints = results.size();
+	size_t p = 0;
+	for (size_t r = 0; r < results.size() && p < pyramids.size(); ++r)
+	{
+		if (results[r].empty()) continue;
+
+		vtkTable* table = resultsTables[p];
+		vtkDoubleArray* arrX = vtkDoubleArray::SafeDownCast(table->GetColumn(0));
+		vtkDoubleArray* arrC = vtkDoubleArray::SafeDownCast(table->GetColumn(1));
+
+		pyramids[p++].Query(xMin, xMax, maxBuckets, visibleIndices);
+		if (!arrX || !arrC || visibleIndices.empty()) continue;
+
+		const vtkIdType numPoints = static_cast<vtkIdType>(visibleIndices.size());
+
+		if (visibleIndices.back() - visibleIndices.front() + 1 == visibleIndices.size())
+		{
+			arrX->SetArray(results[r].energies.data() + visibleIndices.front(), numPoints, 1);
+			arrC->SetArray(results[r].crossSections.data() + visibleIndices.front(), numPoints, 1);
+		}
+		else
+		{
+			// the arrays could still have the columns of the results from above, so the decimated points go in new ones,
+			// with their own memory, writing them in the old ones would overwrite the results
+			vtkNew<vtkDoubleArray> decimatedX;
+			decimatedX->SetName(arrX->GetName());
+			decimatedX->SetNumberOfValues(numPoints);
+
+			vtkNew<vtkDoubleArray> decimatedC;
+			decimatedC->SetName(arrC->GetName());
+			decimatedC->SetNumberOfValues(numPoints);
+
+			for (vtkIdType i = 0; i < numPoints; ++i)
+			{
+				decimatedX->SetValue(i, results[r].energies[visibleIndices[i]]);
+				decimatedC->SetValue(i, results[r].crossSections[visibleIndices[i]]);
+			}
+
+			// the columns with the same name are replaced, in the same position
+			table->AddColumn(decimatedX.GetPointer());
+			table->AddColumn(decimatedC.GetPointer());
+
+			arrX = decimatedX.GetPointer();
+			arrC = decimatedC.GetPointer();
+		}
+
+		arrX->Modified();
+		arrC->Modified();
+		table->Modified();
+	}
+}
 
+// the range of the energy axis changed, it's called for changes done by the chart, too, for example when it sets the range from the bounds of the points
+void ScatteringFrame::OnEnergyRangeChanged(vtkObject* /*caller*/, unsigned long /*eventId*/, void* /*callData*/)
+{
+	if (resultsTables.empty()) return;
 
-	// set up the data table
+	vtkAxis* axis = pChart->GetAxis(vtkAxis::BOTTOM);
+	if (axis->GetMinimum() == plottedMin && axis->GetMaximum() == plottedMax) return;
+
+	UpdateResultsPlots(axis->GetMinimum(), axis->GetMaximum());
+}
+
+void ScatteringFrame::AddMeasurementsPlot(const std::vector<Scattering::Measurement>& measurements, double rho)
+{
+	if (measurements.empty()) return;
+
+	const vtkIdType numPoints = static_cast<vtkIdType>(measurements.size());
 
 	vtkNew<vtkTable> table;
 
-	vtkNew<vtkFloatArray> arrX;
+	vtkNew<vtkDoubleArray> arrX;
 	arrX->SetName("X");
+	arrX->SetNumberOfValues(numPoints);
 	table->AddColumn(arrX.GetPointer());
 
-	vtkNew<vtkFloatArray> arrC;
-	arrC->SetName("Y");
+	vtkNew<vtkDoubleArray> arrC;
+	arrC->SetName("Measured");
+	arrC->SetNumberOfValues(numPoints);
 	table->AddColumn(arrC.GetPointer());
 
-	table->SetNumberOfRows(numPoints);
+	// the measurements are in Angstroms^2, the chart is in rho^2
+	for (vtkIdType i = 0; i < numPoints; ++i)
+	{
+		arrX->SetValue(i, measurements[i].energy);
+		arrC->SetValue(i, measurements[i].crossSection / (rho * rho));
+	}
+
+	vtkPlot *points = pChart->AddPlot(vtkChart::POINTS);
+	points->SetInputData(table.GetPointer(), 0, 1);
+	points->SetColor(0, 0, 0, 255);
+
+	pChart->SetShowLegend(true);
+}
+
+// a points plot for each pair, filled while computing by AddLivePoints
+// the points come in no particular order, so they are not joined by lines, when the computation is finished AddResultsPlots replaces them with the lines
+void ScatteringFrame::StartLivePlots(const std::vector<std::string>& names)
+{
+	ConfigureVTK(names);
 
+	liveTables.clear();
 
-	// set values for X axis column
-	for (int i = 0; i < numPoints; ++i)
+	for (size_t p = 0; p < names.size(); ++p)
 	{
-		table->SetValue(i, 0, results[i].first);
-		table->SetValue(i, 1, results[i].second);
+		vtkNew<vtkTable> table;
+
+		vtkNew<vtkDoubleArray> arrX;
+		arrX->SetName("X");
+		table->AddColumn(arrX.GetPointer());
+
+		vtkNew<vtkDoubleArray> arrC;
+		arrC->SetName(names[p].c_str());
+		table->AddColumn(arrC.GetPointer());
+
+		vtkPlot *points = pChart->AddPlot(vtkChart::POINTS);
+		points->SetInputData(table.GetPointer(), 0, 1);
+
+		const unsigned char* color = plotColors[p % WXSIZEOF(plotColors)];
+		points->SetColor(color[0], color[1], color[2], 255);
+
+		liveTables.push_back(table.GetPointer());
 	}
+}
+
+// appends the points computed since the last call to the live tables, the ones already there are not touched
+void ScatteringFrame::AddLivePoints()
+{
+	pointsStream.Take(streamedPoints);
 
+	bool added = false;
+	for (size_t p = 0; p < streamedPoints.size() && p < liveTables.size(); ++p)
+	{
+		if (streamedPoints[p].empty()) continue;
 
-	// add the line to the chart
+		vtkTable* table = liveTables[p];
+		vtkDoubleArray* arrX = vtkDoubleArray::SafeDownCast(table->GetColumn(0));
+		vtkDoubleArray* arrC = vtkDoubleArray::SafeDownCast(table->GetColumn(1));
+		if (!arrX || !arrC) continue;
 
-	vtkPlot *line = pChart->AddPlot(vtkChart::LINE);
-	// Use columns 0 and 1 for x and y
-	line->SetInputData(table.GetPointer(), 0, 1);
-	  
-	// Make the plot red, with a width of 2.0 pixels
-	line->SetColor(255, 0, 0, 255);
-	line->SetWidth(2.0);		
+		for (const auto& point : streamedPoints[p])
+		{
+			arrX->InsertNextValue(point.first);
+			arrC->InsertNextValue(point.second);
+		}
+
+		arrX->Modified();
+		arrC->Modified();
+		table->Modified();
+
+		added = true;
+	}
+
+	if (added)
+	{
+		pChart->RecalculateBounds();
+		Refresh();
+	}
+}
+
+std::vector<std::string> ScatteringFrame::getComputedPairsNames() const
+{
+	std::vector<std::string> names;
+	for (int pair : computedPairs)
+		names.push_back(computeOptions.scatteringPairs[pair].pairName);
+
+	if (!measurements.empty() && !names.empty()) names.front() += " fit";
+
+	return names;
 }
 
 bool ScatteringFrame::isFinished() const
@@ -190,41 +444,122 @@ void ScatteringFrame::OnOptions(wxCommandEvent& /*event*/)
 }
 
 
-void ScatteringFrame::Compute()
+void ScatteringFrame::Compute(const std::vector<int>& pairs)
 {
-	if (!isFinished()) return;
+	// a new computation replaces the running one
+	CancelComputation();
 
 	wxBeginBusyCursor();
 
 	
 	computeOptions = currentOptions;
+	computedPairs = pairs;
 
 	SetTitle("Computing - Scattering");
 
 	runningThreads = 1;
 
-	std::thread([this]()
+	const unsigned int job = ++computation;
+	computing = true;
+	computeStart = std::chrono::steady_clock::now();
+
+	// the events are posted from the pool threads, CallAfter is thread safe
+	pointsStream.Reset(computedPairs.size());
+	pointsStream.setNotify([this, job]() { CallAfter(&ScatteringFrame::OnPointsComputed, job); });
+	StartLivePlots(getComputedPairsNames());
+
+	// the pool is idle here, so it can be resized if the options changed
+	Scattering::ComputeContext& context = wxGetApp().computeContext;
+	context.threadPool.Resize(computeOptions.nrThreads > 0 ? static_cast<unsigned int>(computeOptions.nrThreads) : 0U);
+	context.resultCache.setDirectory(computeOptions.diskCache ? Options::GetCacheDir() : std::string(), static_cast<size_t>(computeOptions.diskCacheSize) * 1024 * 1024);
+
+	context.threadPool.Submit([this, &context, job]()
 	{
-		results = Scattering::Scattering::Compute(computeOptions);
+		if (measurements.empty())
+		{
+			// all pairs at once, their energies share the pool threads
+			results = Scattering::Scattering::Compute(computeOptions, computedPairs, context, &pointsStream);
+		}
+		else
+		{
+			// the fitted cross section is computed over the whole energy range, to be compared with the measurements
+			fitResult = Scattering::Fit::Run(computeOptions, computeOptions.scatteringPairs[computedPairs.front()], measurements, context, Scattering::FitSettings(),
+				[this, job](unsigned int iteration, double chiSquare, const Scattering::ScatteringPair& /*pair*/)
+				{
+					// the method pointer overloads of CallAfter take at most two arguments
+					CallAfter([this, job, iteration, chiSquare]() { OnFitIteration(job, iteration, chiSquare); });
+				}, &pointsStream);
+
+			if (fitResult.cancelled) results.clear();
+			else results.assign(1, Scattering::Scattering::Compute(computeOptions, fitResult.pair, context, &pointsStream));
+		}
+
+		// posted before clearing the flag, after that the frame can be destroyed (see OnClose)
+		CallAfter(&ScatteringFrame::OnComputeFinished, job);
 
 		runningThreads = 0;
-	}).detach();
+	});
+}
+
 
-	timer.Start(100);	
+void ScatteringFrame::OnPointsComputed(unsigned int job)
+{
+	if (job != computation || !computing) return;
+
+	AddLivePoints();
+	ShowProgress();
 }
 
+void ScatteringFrame::OnFitIteration(unsigned int job, unsigned int iteration, double chiSquare)
+{
+	if (job != computation || !computing) return;
 
-void ScatteringFrame::OnTimer(wxTimerEvent& WXUNUSED(event))
-{	
-	if (isFinished())
-	{
-		timer.Stop();
-		StopThreads();
+	SetStatusText(wxString::Format("Fitting: iteration %u, chi square %g", iteration, chiSquare));
+}
 
-		SetTitle("Finished - Scattering");
+void ScatteringFrame::OnComputeFinished(unsigned int job)
+{
+	if (job != computation || !computing) return;
 
-		Refresh();
-	}
+	StopThreads();
+
+	SetTitle("Finished - Scattering");
+
+	Refresh();
+}
+
+// the fraction of the points computed so far, from the ones received by the stream
+// with the adaptive energy grid it's only an estimate, nrPoints is the maximum there
+void ScatteringFrame::ShowProgress()
+{
+	const double expected = static_cast<double>(computedPairs.size()) * (computeOptions.nrPoints + 1.);
+	const double fraction = std::min(1., static_cast<double>(pointsStream.getNrPoints()) / expected);
+	if (fraction <= 0 || fraction >= 1) return;
+
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - computeStart).count();
+
+	SetStatusText(wxString::Format("Computing: %.0f%%, about %.0f s left", 100. * fraction, elapsed * (1. - fraction) / fraction));
+}
+
+// stops the running computation, if any, and waits for its task to end, the computation checks for cancellation often, so it takes only a few milliseconds
+// the pool threads are free for the next computation after it
+// it waits for the task even if the computation is finished, its task clears runningThreads after posting OnComputeFinished, so it can still be ending
+void ScatteringFrame::CancelComputation()
+{
+	if (computing) pointsStream.Cancel();
+
+	while (!isFinished())
+		wxMilliSleep(1);
+
+	if (computing) StopThreads(true);
+}
+
+// the computation uses the frame, so it must be stopped before the frame is destroyed
+void ScatteringFrame::OnClose(wxCloseEvent& event)
+{
+	CancelComputation();
+
+	event.Skip();
 }
 
 void ScatteringFrame::OnEraseBackground(wxEraseEvent &event)
@@ -239,6 +574,30 @@ void ScatteringFrame::OnExit(wxCommandEvent& /*event*/)
 	Close(true);
 }
 
+void ScatteringFrame::OnExport(wxCommandEvent& /*event*/)
+{
+	wxFileDialog dialog(this, "Export results", "", "", "CSV files (*.csv)|*.csv|Text files (*.txt)|*.txt", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+	if (wxID_OK != dialog.ShowModal()) return;
+
+	FILE* file = wxFopen(dialog.GetPath(), "w");
+	if (!file)
+	{
+		wxMessageBox("Cannot open the file for writing", "Export", wxOK | wxICON_ERROR, this);
+		return;
+	}
+
+	const std::vector<std::string> names = getComputedPairsNames();
+	bool ok = 0 == dialog.GetFilterIndex() ? Scattering::Export::WriteCSV(file, names, results) : Scattering::Export::WriteText(file, names, results);
+	ok = 0 == fclose(file) && ok;
+
+	if (!ok) wxMessageBox("Error writing the results", "Export", wxOK | wxICON_ERROR, this);
+}
+
+void ScatteringFrame::OnUpdateExport(wxUpdateUIEvent& event)
+{
+	event.Enable(!computing && !results.empty());
+}
+
 void ScatteringFrame::OnAbout(wxCommandEvent& /*event*/)
 {
 	wxAboutDialogInfo info;
@@ -260,14 +619,76 @@ void ScatteringFrame::OnAbout(wxCommandEvent& /*event*/)
 	wxAboutBox(info, this);	
 }
 
+void ScatteringFrame::OnBesselTest(wxCommandEvent& /*event*/)
+{
+	wxBusyCursor busy;
+
+	const std::vector<Scattering::BesselTest::Result> testResults = Scattering::BesselTest::Run(currentOptions);
+
+	wxMessageBox(Scattering::BesselTest::Report(currentOptions, testResults), "Bessel functions test", wxOK | wxICON_INFORMATION, this);
+}
+
+
+void ScatteringFrame::OnFit(wxCommandEvent& /*event*/)
+{
+	wxFileDialog dialog(this, "Measured cross sections", "", "", "Data files (*.txt;*.csv;*.dat)|*.txt;*.csv;*.dat|All files (*.*)|*.*", wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+	if (wxID_OK != dialog.ShowModal()) return;
+
+	std::vector<Scattering::Measurement> data;
+	std::string error;
+	if (!Scattering::Fit::LoadMeasurements(dialog.GetPath().ToStdString(), data, error))
+	{
+		wxMessageBox(error, "Fit", wxOK | wxICON_ERROR, this);
+		return;
+	}
+
+	CancelComputation();
+
+	measurements.swap(data);
+	Compute(std::vector<int>{ currentOptions.scatteringPair });
+}
+
+// the files are deleted even if the disk cache is disabled now, they could be there from before
+void ScatteringFrame::OnClearCache(wxCommandEvent& /*event*/)
+{
+	Scattering::ComputeContext& context = wxGetApp().computeContext;
+	context.resultCache.Clear();
+	Scattering::ResultCache::RemoveFiles(Options::GetCacheDir());
+
+	SetStatusText("The results cache is cleared");
+}
+
 
 void ScatteringFrame::StopThreads(bool cancel)
 {
 	SetTitle("Finished - Scattering");
 
+	computing = false;
+
+	// the live plots are replaced by the ones with the results, or dropped if cancelled
+	liveTables.clear();
+	if (cancel) pChart->ClearPlots();
 
 	if (!cancel)
-		ConfigureVTK(computeOptions.scatteringPairs[computeOptions.scatteringPair].pairName, results);
+	{
+		const std::vector<std::string> names = getComputedPairsNames();
+		ConfigureVTK(names);
+		AddResultsPlots(names);
+		if (!measurements.empty()) AddMeasurementsPlot(measurements, fitResult.pair.rho);
+
+		std::vector<unsigned int> allPartialWaves;
+		for (const auto& pairResults : results)
+			allPartialWaves.insert(allPartialWaves.end(), pairResults.partialWaves.begin(), pairResults.partialWaves.end());
+
+		if (!measurements.empty())
+			SetStatusText(wxString::Format("Fit: epsilon %.5g +- %.2g meV, rho %.5g +- %.2g A, chi square %g, %u iterations%s", fitResult.pair.epsilon, fitResult.epsilonError,
+				fitResult.pair.rho, fitResult.rhoError, fitResult.chiSquare, fitResult.iterations, fitResult.converged ? "" : " (not converged)"));
+		else if (!allPartialWaves.empty())
+		{
+			const auto minmax = std::minmax_element(allPartialWaves.begin(), allPartialWaves.end());
+			SetStatusText(wxString::Format("Partial waves used: l up to %u (minimum %u)", *minmax.second, *minmax.first));
+		}
+	}
 
 
 	if (wxIsBusy()) wxEndBusyCursor();
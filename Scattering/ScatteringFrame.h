@@ -31,8 +31,8 @@
 
 #include "vtkTable.h"
 #include "vtkArray.h"
-#include "VtkFloatArray.h"
 #include "vtkNew.h"
+#include "vtkSmartPointer.h"
 #include "vtkChart.h"
 #include "vtkChartXY.h"
 
@@ -42,10 +42,15 @@
 #include "vtkAxis.h"
 
 #include <atomic>
+#include <chrono>
 #include <list>
 
 
 #include "Options.h"
+#include "Fit.h"
+#include "ComputeMonitor.h"
+#include "Results.h"
+#include "MinMaxPyramid.h"
 
 class ScatteringFrame : public wxFrame
 {
@@ -69,29 +74,69 @@ private:
 
 	vtkChartXY *pChart = nullptr;
 
-	wxTimer timer;
+	// the worker posts events to the frame (see CallAfter) with the number of the computation, the ones from a cancelled computation are ignored
+	unsigned int computation = 0;
+	bool computing = false;
+	std::chrono::steady_clock::time_point computeStart;
 
 	Options computeOptions; // what's actually displayed
 
-	std::vector<std::pair<double, double>> results;
+	// for each of the computed pairs
+	// the plots of the results use their columns directly (see AddResultsPlots), so they are changed only while there are no such plots, by the computation
+	std::vector<int> computedPairs;
+	std::vector<Scattering::Results> results;
+
+	// the plots of the results get only the points that can be seen in the energy range shown, see UpdateResultsPlots
+	std::vector<Scattering::MinMaxPyramid> pyramids;
+	std::vector<vtkSmartPointer<vtkTable>> resultsTables;
+	std::vector<size_t> visibleIndices;
+	double plottedMin = 0;
+	double plottedMax = 0;
+
+	// the points computed so far go here, they are shown when the worker notifies about them, in the live tables, one for each pair
+	Scattering::PointsStream pointsStream;
+	std::vector<std::vector<std::pair<double, double>>> streamedPoints;
+	std::vector<vtkSmartPointer<vtkTable>> liveTables;
+
+	// if not empty, the computation is a fit to them, starting from the parameters of the first computed pair
+	std::vector<Scattering::Measurement> measurements;
+	Scattering::Fit::Result fitResult;
 
 	void ConstructVTK();
 	void DestroyVTK();
 
-	void ConfigureVTK(const std::string& name, const std::vector<std::pair<double, double>>& results);
+	void ConfigureVTK(const std::vector<std::string>& names);
+	void AddResultsPlots(const std::vector<std::string>& names);
+	void UpdateResultsPlots(double xMin, double xMax);
+	void OnEnergyRangeChanged(vtkObject* caller, unsigned long eventId, void* callData);
+	void AddMeasurementsPlot(const std::vector<Scattering::Measurement>& measurements, double rho);
+	void StartLivePlots(const std::vector<std::string>& names);
+	void AddLivePoints();
+
+	std::vector<std::string> getComputedPairsNames() const;
 
 	bool isFinished() const;
 	void StopThreads(bool cancel = false);
-	void Compute();
+	void CancelComputation();
+	void Compute(const std::vector<int>& pairs);
 
 	void OnExit(wxCommandEvent& event);
 	void OnOptions(wxCommandEvent& event);
 	void OnAbout(wxCommandEvent& event);
-	void OnTimer(wxTimerEvent& event);
+	void OnBesselTest(wxCommandEvent& event);
+	void OnFit(wxCommandEvent& event);
+	void OnClearCache(wxCommandEvent& event);
+	void OnPointsComputed(unsigned int job);
+	void OnFitIteration(unsigned int job, unsigned int iteration, double chiSquare);
+	void OnComputeFinished(unsigned int job);
+	void ShowProgress();
 	void OnEraseBackground(wxEraseEvent &event);
+	void OnClose(wxCloseEvent& event);
 
 	void OnCalculate(wxCommandEvent& event);
-	void OnUpdateCalculate(wxUpdateUIEvent& event);
+	void OnCalculateBatch(wxCommandEvent& event);
+	void OnExport(wxCommandEvent& event);
+	void OnUpdateExport(wxUpdateUIEvent& event);
 
 	wxDECLARE_EVENT_TABLE();
 };
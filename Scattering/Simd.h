@@ -0,0 +1,258 @@
+#pragma once
+
+// a minimal wrapper over the SIMD double precision registers, enough for the batched integrator and the polynomial kernels in SimdMath.h
+// the width is chosen at compile time: AVX-512 (8 lanes), AVX/AVX2 (4 lanes) or plain scalar code over 4 lanes
+// the operations are not fused (no FMA), so each lane gives exactly the same result as the scalar code doing the same operations in the same order
+
+#include <cmath>
+#include <cstddef>
+#include <new>
+
+#if defined(__AVX512F__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace Simd
+{
+
+#if defined(__AVX512F__)
+
+	constexpr size_t Lanes = 8;
+
+	class Mask
+	{
+	public:
+		explicit Mask(__mmask8 value) : m(value) {}
+
+		Mask operator|(const Mask& other) const { return Mask(m | other.m); }
+
+		__mmask8 m;
+	};
+
+	class Pack
+	{
+	public:
+		Pack() = default;
+		explicit Pack(double value) : v(_mm512_set1_pd(value)) {}
+		explicit Pack(__m512d value) : v(value) {}
+
+		static Pack Load(const double* ptr) { return Pack(_mm512_loadu_pd(ptr)); }
+		void Store(double* ptr) const { _mm512_storeu_pd(ptr, v); }
+
+		Pack operator+(const Pack& other) const { return Pack(_mm512_add_pd(v, other.v)); }
+		Pack operator-(const Pack& other) const { return Pack(_mm512_sub_pd(v, other.v)); }
+		Pack operator*(const Pack& other) const { return Pack(_mm512_mul_pd(v, other.v)); }
+		Pack operator/(const Pack& other) const { return Pack(_mm512_div_pd(v, other.v)); }
+		Pack operator-() const { return Pack(_mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(v), _mm512_set1_epi64(0x8000000000000000LL)))); }
+
+		Mask operator<(const Pack& other) const { return Mask(_mm512_cmp_pd_mask(v, other.v, _CMP_LT_OQ)); }
+		Mask operator>(const Pack& other) const { return Mask(_mm512_cmp_pd_mask(v, other.v, _CMP_GT_OQ)); }
+
+		static Pack Floor(const Pack& p) { return Pack(_mm512_roundscale_pd(p.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)); }
+		static Pack Abs(const Pack& p) { return Pack(_mm512_abs_pd(p.v)); }
+		static Pack Sqrt(const Pack& p) { return Pack(_mm512_sqrt_pd(p.v)); }
+
+		// mask ? ifTrue : ifFalse, for each lane
+		static Pack Select(const Mask& mask, const Pack& ifTrue, const Pack& ifFalse) { return Pack(_mm512_mask_blend_pd(mask.m, ifFalse.v, ifTrue.v)); }
+
+	private:
+		__m512d v;
+	};
+
+#elif defined(__AVX__)
+
+	constexpr size_t Lanes = 4;
+
+	class Mask
+	{
+	public:
+		explicit Mask(__m256d value) : m(value) {}
+
+		Mask operator|(const Mask& other) const { return Mask(_mm256_or_pd(m, other.m)); }
+
+		__m256d m;
+	};
+
+	class Pack
+	{
+	public:
+		Pack() = default;
+		explicit Pack(double value) : v(_mm256_set1_pd(value)) {}
+		explicit Pack(__m256d value) : v(value) {}
+
+		static Pack Load(const double* ptr) { return Pack(_mm256_loadu_pd(ptr)); }
+		void Store(double* ptr) const { _mm256_storeu_pd(ptr, v); }
+
+		Pack operator+(const Pack& other) const { return Pack(_mm256_add_pd(v, other.v)); }
+		Pack operator-(const Pack& other) const { return Pack(_mm256_sub_pd(v, other.v)); }
+		Pack operator*(const Pack& other) const { return Pack(_mm256_mul_pd(v, other.v)); }
+		Pack operator/(const Pack& other) const { return Pack(_mm256_div_pd(v, other.v)); }
+		Pack operator-() const { return Pack(_mm256_xor_pd(v, _mm256_set1_pd(-0.))); }
+
+		Mask operator<(const Pack& other) const { return Mask(_mm256_cmp_pd(v, other.v, _CMP_LT_OQ)); }
+		Mask operator>(const Pack& other) const { return Mask(_mm256_cmp_pd(v, other.v, _CMP_GT_OQ)); }
+
+		static Pack Floor(const Pack& p) { return Pack(_mm256_floor_pd(p.v)); }
+		static Pack Abs(const Pack& p) { return Pack(_mm256_andnot_pd(_mm256_set1_pd(-0.), p.v)); }
+		static Pack Sqrt(const Pack& p) { return Pack(_mm256_sqrt_pd(p.v)); }
+
+		// mask ? ifTrue : ifFalse, for each lane
+		static Pack Select(const Mask& mask, const Pack& ifTrue, const Pack& ifFalse) { return Pack(_mm256_blendv_pd(ifFalse.v, ifTrue.v, mask.m)); }
+
+	private:
+		__m256d v;
+	};
+
+#else
+
+	// scalar fallback, the compiler might still vectorize the loops
+	constexpr size_t Lanes = 4;
+
+	class Mask
+	{
+	public:
+		Mask operator|(const Mask& other) const
+		{
+			Mask res;
+			for (size_t i = 0; i < Lanes; ++i) res.m[i] = m[i] || other.m[i];
+			return res;
+		}
+
+		bool m[Lanes];
+	};
+
+	class Pack
+	{
+	public:
+		Pack() = default;
+		explicit Pack(double value)
+		{
+			for (size_t i = 0; i < Lanes; ++i) v[i] = value;
+		}
+
+		static Pack Load(const double* ptr)
+		{
+			Pack res;
+			for (size_t i = 0; i < Lanes; ++i) res.v[i] = ptr[i];
+			return res;
+		}
+
+		void Store(double* ptr) const
+		{
+			for (size_t i = 0; i < Lanes; ++i) ptr[i] = v[i];
+		}
+
+		Pack operator+(const Pack& other) const
+		{
+			Pack res;
+			for (size_t i = 0; i < Lanes; ++i) res.v[i] = v[i] + other.v[i];
+			return res;
+		}
+
+		Pack operator-(const Pack& other) const
+		{
+			Pack res;
+			for (size_t i = 0; i < Lanes; ++i) res.v[i] = v[i] - other.v[i];
+			return res;
+		}
+
+		Pack operator*(const Pack& other) const
+		{
+			Pack res;
+			for (size_t i = 0; i < Lanes; ++i) res.v[i] = v[i] * other.v[i];
+			return res;
+		}
+
+		Pack operator/(const Pack& other) const
+		{
+			Pack res;
+			for (size_t i = 0; i < Lanes; ++i) res.v[i] = v[i] / other.v[i];
+			return res;
+		}
+
+		Pack operator-() const
+		{
+			Pack res;
+			for (size_t i = 0; i < Lanes; ++i) res.v[i] = -v[i];
+			return res;
+		}
+
+		Mask operator<(const Pack& other) const
+		{
+			Mask res;
+			for (size_t i = 0; i < Lanes; ++i) res.m[i] = v[i] < other.v[i];
+			return res;
+		}
+
+		Mask operator>(const Pack& other) const
+		{
+			Mask res;
+			for (size_t i = 0; i < Lanes; ++i) res.m[i] = v[i] > other.v[i];
+			return res;
+		}
+
+		static Pack Floor(const Pack& p)
+		{
+			Pack res;
+			for (size_t i = 0; i < Lanes; ++i) res.v[i] = std::floor(p.v[i]);
+			return res;
+		}
+
+		static Pack Abs(const Pack& p)
+		{
+			Pack res;
+			for (size_t i = 0; i < Lanes; ++i) res.v[i] = std::abs(p.v[i]);
+			return res;
+		}
+
+		static Pack Sqrt(const Pack& p)
+		{
+			Pack res;
+			for (size_t i = 0; i < Lanes; ++i) res.v[i] = std::sqrt(p.v[i]);
+			return res;
+		}
+
+		// mask ? ifTrue : ifFalse, for each lane
+		static Pack Select(const Mask& mask, const Pack& ifTrue, const Pack& ifFalse)
+		{
+			Pack res;
+			for (size_t i = 0; i < Lanes; ++i) res.v[i] = mask.m[i] ? ifTrue.v[i] : ifFalse.v[i];
+			return res;
+		}
+
+	private:
+		double v[Lanes];
+	};
+
+#endif
+
+
+	// for std::vector, to have the data aligned for vector loads
+	template<typename T, size_t Alignment = 64> class AlignedAllocator
+	{
+	public:
+		typedef T value_type;
+
+		template<typename U> struct rebind
+		{
+			typedef AlignedAllocator<U, Alignment> other;
+		};
+
+		AlignedAllocator() = default;
+		template<typename U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+		T* allocate(size_t n)
+		{
+			return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+		}
+
+		void deallocate(T* ptr, size_t /*n*/)
+		{
+			::operator delete(ptr, std::align_val_t(Alignment));
+		}
+
+		template<typename U> bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+		template<typename U> bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+	};
+
+}
@@ -19,6 +19,12 @@
 #include <cmath>
 #endif
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "SimdMath.h"
+
 namespace SpecialFunctions
 {
 	// for now I'll let the ones implemented here
@@ -49,6 +55,9 @@ namespace SpecialFunctions
 			if (0 == l) return sin(x) / x;
 			else if (1 == l) return  sin(x) / (x * x) - cos(x) / x;
 
+			// the upward recurrence loses precision for l > x, use the backward one there
+			if (l > x) return Backward(l, x, sin(x), cos(x));
+
 			const double sinxx = sin(x) / x;
 			const double cosxx = cos(x) / x;
 
@@ -101,6 +110,17 @@ namespace SpecialFunctions
 #endif
 		}
 
+		// for the automatic differentiation types (see Dual.h in Scattering): the values for the value of x, the derivatives with the chain rule
+		template<typename T> static T j(unsigned int l, const T& x)
+		{
+			return T::Chain(x, j(l, x.getValue()), jderiv(l, x.getValue()));
+		}
+
+		template<typename T> static T n(unsigned int l, const T& x)
+		{
+			return T::Chain(x, n(l, x.getValue()), nderiv(l, x.getValue()));
+		}
+
 		template<typename T> static T jderiv(unsigned int l, const T& x)
 		{
 			return T(l) / x * j(l, x) - j(l + 1, x);
@@ -114,6 +134,60 @@ namespace SpecialFunctions
 		}
 
 
+		// Miller's algorithm: j is computed with the recurrence going down, from an order high enough that the starting values don't matter
+		// the result is normalized with j0 or j1 (the larger of them), so it's as precise as the sin and cos passed
+		// it's stable for any l, the upward recurrence is not for l > x, because j decreases fast with l there and the errors grow as n does
+		// if values is not null, it gets j for all orders from 0 to l
+		static double Backward(unsigned int l, double x, double sinx, double cosx, double* values = nullptr)
+		{
+			// j_k behaves like (e x / (2k))^k for k > x, so starting a number of orders past l that grows as the square root of the order is enough for double precision
+			const double top = std::max(static_cast<double>(l), x);
+			const unsigned int start = static_cast<unsigned int>(top + 10. * sqrt(top + 10.)) + 10;
+
+			const double big = 1E250;
+			const double small = 1E-250;
+
+			double jnext = 0;
+			double jcur = small;
+			double jl = 0;
+
+			for (unsigned int k = start; k > 0; --k)
+			{
+				const double jprev = (2. * k + 1.) / x * jcur - jnext;
+				jnext = jcur;
+				jcur = jprev;
+
+				// now jcur is for k - 1, jnext for k
+				if (k - 1 <= l)
+				{
+					if (values) values[k - 1] = jcur;
+					if (k - 1 == l) jl = jcur;
+				}
+
+				// rescale to avoid overflow, the ones already stored are affected, too
+				if (std::abs(jcur) > big)
+				{
+					jcur *= small;
+					jnext *= small;
+					jl *= small;
+					if (values)
+						for (unsigned int i = k - 1; i <= l && i < start; ++i)
+							values[i] *= small;
+				}
+			}
+
+			// jcur is j0, jnext is j1, not normalized
+			const double j0 = sinx / x;
+			const double j1 = (sinx / x - cosx) / x;
+			const double scale = (std::abs(j0) > std::abs(j1)) ? j0 / jcur : j1 / jnext;
+
+			if (values)
+				for (unsigned int i = 0; i <= l; ++i)
+					values[i] *= scale;
+
+			return jl * scale;
+		}
+
 		/*
 		protected:
 			inline static double j0(double x) { return sin(x) / x; }
@@ -124,6 +198,152 @@ namespace SpecialFunctions
 		*/
 	};
 
+	// the ways the Bessel functions tables can be computed, selectable at runtime
+	// ints, to be usable with the wxWidgets validators (see Options)
+	enum BesselMethod : int
+	{
+		StandardLibrary = 0, // std::sph_bessel and std::sph_neumann, precise but slow, available only with USE_BETTER_BESSEL, otherwise StableRecurrence is used instead
+		UpwardRecurrence, // the old implementation, fast but j is wrong for l > x
+		StableRecurrence // upward recurrence for n and for j with l < x, backward recurrence for j otherwise
+	};
+
+	inline constexpr bool isStandardLibraryAvailable()
+	{
+#ifdef USE_BETTER_BESSEL
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	// sin and cos for count values at once, the ones needed by the Bessel functions tables for a batch of energies
+	// computed with the SIMD kernels, Simd::Lanes values at a time, the last ones padded
+	inline void SinCos(size_t count, const double* x, double* s, double* c)
+	{
+		for (size_t i = 0; i < count; i += Simd::Lanes)
+		{
+			const size_t nr = std::min(Simd::Lanes, count - i);
+
+			double xs[Simd::Lanes];
+			for (size_t j = 0; j < Simd::Lanes; ++j)
+				xs[j] = x[i + std::min(j, nr - 1)];
+
+			Simd::Pack sinx;
+			Simd::Pack cosx;
+			Simd::SinCos(Simd::Pack::Load(xs), sinx, cosx);
+
+			double ss[Simd::Lanes];
+			double cs[Simd::Lanes];
+			sinx.Store(ss);
+			cosx.Store(cs);
+
+			for (size_t j = 0; j < nr; ++j)
+			{
+				s[i + j] = ss[j];
+				c[i + j] = cs[j];
+			}
+		}
+	}
+
+	// all the orders from 0 to L for the same x, with the derivatives, computed in a single pass
+	// the phase shifts for all partial waves at an energy need them at the same x, so it's much cheaper than calling the functions above for each l
+	// see BesselMethod for the ways they can be computed
+	class BesselTable
+	{
+	public:
+		BesselTable() = default;
+
+		BesselTable(unsigned int L, double x, BesselMethod method = StableRecurrence)
+		{
+			Compute(L, x, method);
+		}
+
+		void Compute(unsigned int L, double x, BesselMethod method = StableRecurrence)
+		{
+			Compute(L, x, sin(x), cos(x), method);
+		}
+
+		// sin and cos of x are passed, for the case when they are computed at once for more values, see SinCos
+		void Compute(unsigned int L, double x, double sinx, double cosx, BesselMethod method = StableRecurrence)
+		{
+			m_x = x;
+			m_L = L;
+
+			// one more order is needed for the derivatives
+			jv.resize(L + 2);
+			nv.resize(L + 2);
+			jd.resize(L + 1);
+			nd.resize(L + 1);
+
+#ifdef USE_BETTER_BESSEL
+			if (StandardLibrary == method)
+			{
+				for (unsigned int i = 0; i <= L + 1; ++i)
+				{
+					jv[i] = std::sph_bessel(i, x);
+					nv[i] = std::sph_neumann(i, x);
+				}
+			}
+			else
+#endif
+			{
+				const double sinxx = sinx / x;
+				const double cosxx = cosx / x;
+
+				// the upward recurrence is stable for n
+				nv[0] = -cosxx;
+				nv[1] = -cosxx / x - sinxx;
+
+				for (unsigned int i = 2; i <= L + 1; ++i)
+					nv[i] = (2. * i - 1.) / x * nv[i - 1] - nv[i - 2];
+
+				if (UpwardRecurrence != method && L + 1 > x)
+					Bessel::Backward(L + 1, x, sinx, cosx, jv.data());
+				else
+				{
+					jv[0] = sinxx;
+					jv[1] = sinxx / x - cosxx;
+
+					for (unsigned int i = 2; i <= L + 1; ++i)
+						jv[i] = (2. * i - 1.) / x * jv[i - 1] - jv[i - 2];
+				}
+			}
+
+			for (unsigned int i = 0; i <= L; ++i)
+			{
+				jd[i] = i / x * jv[i] - jv[i + 1];
+				nd[i] = i / x * nv[i] - nv[i + 1];
+			}
+
+			// n grows like (2l)! / (2^l l! x^(l+1)) for l > x, for large l and small x it overflows, j underflows to 0 there
+			// the orders from the first one with n or its derivative not finite are not usable, see isFinite
+			m_nrFinite = 0;
+			while (m_nrFinite <= L && std::isfinite(nv[m_nrFinite]) && std::isfinite(nd[m_nrFinite]))
+				++m_nrFinite;
+		}
+
+		inline double getX() const { return m_x; }
+		inline unsigned int getMaxL() const { return m_L; }
+
+		// false if n overflowed for l, the wave does not reach r then, so the phase shift is 0, as if the potential were not there
+		inline bool isFinite(unsigned int l) const { return l < m_nrFinite; }
+
+		inline double j(unsigned int l) const { return jv[l]; }
+		inline double n(unsigned int l) const { return nv[l]; }
+		inline double jderiv(unsigned int l) const { return jd[l]; }
+		inline double nderiv(unsigned int l) const { return nd[l]; }
+
+	protected:
+		double m_x = 0;
+		unsigned int m_L = 0;
+		unsigned int m_nrFinite = 0;
+
+		std::vector<double> jv;
+		std::vector<double> nv;
+		std::vector<double> jd;
+		std::vector<double> nd;
+	};
+
 	// Legendre polynomials, not used currently, can be used to compute differential cross section
 	class Legendre
 	{
@@ -0,0 +1,156 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace Scattering
+{
+
+	namespace
+	{
+		// identifies the pool and the queue of the worker running on the current thread
+		thread_local const ThreadPool* currentPool = nullptr;
+		thread_local unsigned int currentIndex = 0;
+	}
+
+
+	ThreadPool::ThreadPool(unsigned int nrThreads)
+	{
+		Start(nrThreads);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		Stop();
+	}
+
+	void ThreadPool::Resize(unsigned int nrThreads)
+	{
+		if (0 == nrThreads) nrThreads = std::max(1U, std::thread::hardware_concurrency());
+		if (nrThreads == getNumberOfThreads()) return;
+
+		Stop();
+		Start(nrThreads);
+	}
+
+	void ThreadPool::Start(unsigned int nrThreads)
+	{
+		if (0 == nrThreads) nrThreads = std::max(1U, std::thread::hardware_concurrency());
+
+		stopping = false;
+
+		queues.clear();
+		for (unsigned int i = 0; i < nrThreads; ++i)
+			queues.emplace_back(std::make_unique<Queue>());
+
+		workers.reserve(nrThreads);
+		for (unsigned int i = 0; i < nrThreads; ++i)
+			workers.emplace_back(&ThreadPool::Work, this, i);
+	}
+
+	void ThreadPool::Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(waitMutex);
+			stopping = true;
+		}
+		waitCondition.notify_all();
+
+		for (auto& worker : workers)
+			worker.join();
+
+		workers.clear();
+	}
+
+	void ThreadPool::Submit(std::function<void()>&& task)
+	{
+		const unsigned int index = isPoolThread() ? currentIndex : nextQueue++ % static_cast<unsigned int>(queues.size());
+
+		{
+			std::lock_guard<std::mutex> lock(queues[index]->mutex);
+			queues[index]->tasks.emplace_back(std::move(task));
+			++pendingTasks;
+		}
+
+		// taking the lock avoids missing a worker that just checked for tasks and is about to wait
+		{
+			std::lock_guard<std::mutex> lock(waitMutex);
+		}
+		waitCondition.notify_one();
+	}
+
+	bool ThreadPool::RunPendingTask()
+	{
+		std::function<void()> task;
+		if (!PopTask(isPoolThread() ? currentIndex : 0, task)) return false;
+
+		task();
+
+		return true;
+	}
+
+	bool ThreadPool::isPoolThread() const
+	{
+		return currentPool == this;
+	}
+
+	bool ThreadPool::PopTask(unsigned int index, std::function<void()>& task)
+	{
+		const unsigned int nrQueues = static_cast<unsigned int>(queues.size());
+
+		// the own queue first, from the back, the most recently submitted task is likely to have its data in cache
+		{
+			Queue& queue = *queues[index];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.tasks.empty())
+			{
+				task = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+				--pendingTasks;
+
+				return true;
+			}
+		}
+
+		// then steal from the front of the others
+		for (unsigned int i = 1; i < nrQueues; ++i)
+		{
+			Queue& queue = *queues[(index + i) % nrQueues];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.tasks.empty())
+			{
+				task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+				--pendingTasks;
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void ThreadPool::Work(unsigned int index)
+	{
+		currentPool = this;
+		currentIndex = index;
+
+		for (;;)
+		{
+			std::function<void()> task;
+			if (PopTask(index, task))
+			{
+				task();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(waitMutex);
+			waitCondition.wait(lock, [this]() { return stopping || pendingTasks > 0; });
+
+			// the queued tasks are finished before exiting
+			if (stopping && 0 == pendingTasks) break;
+		}
+
+		currentPool = nullptr;
+	}
+
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Scattering
+{
+
+	// a work stealing thread pool
+	// each worker has its own queue, it takes tasks from the back of it and when it runs out of them it steals from the front of the other queues
+	// tasks submitted from outside the pool are distributed round robin over the queues, tasks submitted from a worker go into its own queue
+	class ThreadPool
+	{
+	public:
+		// 0 means as many threads as the hardware supports
+		explicit ThreadPool(unsigned int nrThreads = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// lets the already submitted tasks finish, then starts the new number of threads
+		// does nothing if the number of threads does not change
+		void Resize(unsigned int nrThreads);
+
+		unsigned int getNumberOfThreads() const { return static_cast<unsigned int>(workers.size()); }
+
+		void Submit(std::function<void()>&& task);
+
+		// calls func(i) for all i in [0, count) on the pool threads and returns when all calls are done
+		// if it's called from a pool thread, that thread executes tasks while waiting, so nested calls are fine
+		template<typename Func> void ParallelFor(size_t count, const Func& func)
+		{
+			if (0 == count) return;
+
+			// the state is shared with the tasks, the last one might still notify after the waiting below returned
+			auto state = std::make_shared<Completion>(count);
+
+			for (size_t i = 0; i < count; ++i)
+				Submit([i, &func, state]()
+				{
+					func(i);
+
+					if (0 == --state->remaining)
+					{
+						std::lock_guard<std::mutex> lock(state->mutex);
+						state->condition.notify_all();
+					}
+				});
+
+			const bool helping = isPoolThread();
+			while (state->remaining)
+			{
+				if (helping && RunPendingTask()) continue;
+
+				std::unique_lock<std::mutex> lock(state->mutex);
+				// a pool thread wakes up from time to time to check whether there is something to help with
+				if (helping)
+					state->condition.wait_for(lock, std::chrono::milliseconds(1), [&state]() { return 0 == state->remaining; });
+				else
+					state->condition.wait(lock, [&state]() { return 0 == state->remaining; });
+			}
+		}
+
+		// executes one of the queued tasks on the calling thread, returns false if there was none
+		bool RunPendingTask();
+
+		bool isPoolThread() const;
+
+	private:
+		struct Completion
+		{
+			explicit Completion(size_t count) : remaining(count) {}
+
+			std::atomic_size_t remaining;
+			std::mutex mutex;
+			std::condition_variable condition;
+		};
+
+		struct Queue
+		{
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		void Start(unsigned int nrThreads);
+		void Stop();
+
+		void Work(unsigned int index);
+		bool PopTask(unsigned int index, std::function<void()>& task);
+
+		std::vector<std::thread> workers;
+		std::vector<std::unique_ptr<Queue>> queues;
+
+		std::mutex waitMutex;
+		std::condition_variable waitCondition;
+		bool stopping = false;
+
+		std::atomic_size_t pendingTasks{ 0 };
+		std::atomic_uint nextQueue{ 0 };
+	};
+
+}
@@ -0,0 +1,364 @@
+#include "Parameters.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+
+
+namespace {
+
+	// same order as the enums in ComputeOptions
+	const char* const potentialNames[] = { "12-6", "8-6", "10-6", "12-6-4" };
+	const char* const engineNames[] = { "numerov", "logderiv" };
+	const char* const besselNames[] = { "std", "upward", "stable" };
+
+	template<size_t N> int FindName(const char* const (&names)[N], const std::string& value)
+	{
+		for (size_t i = 0; i < N; ++i)
+			if (value == names[i]) return static_cast<int>(i);
+
+		return -1;
+	}
+
+	std::string Trim(const std::string& str)
+	{
+		const size_t start = str.find_first_not_of(" \t\r\n");
+		if (std::string::npos == start) return "";
+
+		const size_t end = str.find_last_not_of(" \t\r\n");
+
+		return str.substr(start, end - start + 1);
+	}
+
+}
+
+
+bool Parameters::Parse(int argc, char* argv[])
+{
+	// the config file first, so the other parameters override the values from it
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+
+		if ("--config" == arg)
+		{
+			if (i + 1 >= argc)
+			{
+				error = "Missing file name for --config";
+				return false;
+			}
+
+			if (!Load(argv[i + 1])) return false;
+			++i;
+		}
+		else if (0 == arg.compare(0, 9, "--config="))
+		{
+			if (!Load(arg.substr(9))) return false;
+		}
+	}
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+
+		if ("-h" == arg)
+		{
+			help = true;
+			continue;
+		}
+		else if (arg.size() < 3 || 0 != arg.compare(0, 2, "--"))
+		{
+			error = "Unexpected argument: " + arg;
+			return false;
+		}
+
+		arg = arg.substr(2);
+
+		std::string value;
+		bool hasValue = false;
+
+		const size_t pos = arg.find('=');
+		if (std::string::npos != pos)
+		{
+			value = arg.substr(pos + 1);
+			arg = arg.substr(0, pos);
+			hasValue = true;
+		}
+		else if (!isFlag(arg) && i + 1 < argc)
+		{
+			value = argv[++i];
+			hasValue = true;
+		}
+
+		if ("config" == arg) continue; // already loaded
+		else if (!Set(arg, value, hasValue)) return false;
+	}
+
+	// the log derivative engine integrates over pairs of steps (see LogDerivativeBatch)
+	if (ComputeOptions::LogDerivativeEngine == options.engine && options.nrIntegrationSteps < 2)
+	{
+		error = "The log derivative engine needs at least 2 integration steps";
+		return false;
+	}
+
+	return true;
+}
+
+
+void Parameters::PrintUsage(FILE* file)
+{
+	fprintf(file,
+		"Computes the total cross section for the scattering on a Lennard-Jones potential\n"
+		"and writes it as lines of energy (meV), cross section (rho^2) and maximum partial wave used\n"
+		"with more pairs, the text output has a block for each of them, separated by two empty lines\n\n"
+		"Usage: ScatteringCLI [--name value]...\n\n"
+		"  --config FILE            parameters from the file, as name = value lines, # starts a comment\n"
+		"  --output FILE            the results go in the file instead of the standard output\n"
+		"  --cache DIR              keep the results in files in the directory (it must exist), a computation\n"
+		"                           with the same pair and options loads them instead of computing again\n"
+		"  --cache-size MB          the most the files in the cache directory can take (default 1024), the least\n"
+		"                           recently used ones are deleted to stay under it\n"
+		"  --clear-cache[=BOOL]     deletes the files in the cache directory first\n"
+		"  --format NAME            text or csv (default text)\n"
+		"  --pair NAME|INDEX        H-Ne, H-Ar, H-Kr, H-Xe, H2-Ar, H2-Kr, H2-Xe (default H-Kr)\n"
+		"  --pairs all|LIST         computes more pairs at once, the list is comma separated\n"
+		"  --potential TYPE         12-6, 8-6, 10-6 or 12-6-4 (default 12-6)\n"
+		"  --gamma VALUE            for the 12-6-4 potential\n"
+		"  --points N               number of energies\n"
+		"  --steps N                integration steps\n"
+		"  --threads N              0 for as many as the hardware supports\n"
+		"  --adaptive-l[=BOOL]      stop adding partial waves when they become negligible\n"
+		"  --max-l N                the maximum partial wave if adaptive, up to 1000\n"
+		"  --l-tolerance VALUE      relative cross section under which a partial wave is negligible\n"
+		"  --negligible-l N         consecutive negligible partial waves needed to stop\n"
+		"  --adaptive-energy[=BOOL] refine the energy grid where the cross section changes fast\n"
+		"  --energy-tolerance VALUE relative cross section change for refining\n"
+		"  --max-phase-change VALUE phase shift change for refining (radians)\n"
+		"  --adaptive-steps[=BOOL]  double the integration steps until the phase shifts converge\n"
+		"  --accuracy VALUE         phase shift accuracy for adaptive steps\n"
+		"  --max-steps N            the maximum integration steps if adaptive\n"
+		"  --engine NAME            numerov or logderiv\n"
+		"  --bessel NAME            std, upward or stable\n"
+		"  --llim N                 the number of partial waves if not adaptive, up to 1000\n"
+		"  --fit FILE               fits epsilon and rho to the measurements in the file, then computes with them\n"
+		"                           the lines have the energy (meV), cross section (A^2) and optionally its error\n"
+		"  --fit-mass[=BOOL]        fits the mass of the second atom, too\n"
+		"  --fit-iterations N       the maximum number of iterations\n"
+		"  --fit-epsilon VALUE      the start value for epsilon (meV), the one of the pair by default\n"
+		"  --fit-rho VALUE          the start value for rho (A), the one of the pair by default\n"
+		"  --bessel-test            compares the Bessel functions methods, instead of computing\n"
+		"  --help                   this text\n");
+}
+
+
+bool Parameters::Load(const std::string& fileName)
+{
+	std::ifstream file(fileName);
+	if (!file)
+	{
+		error = "Cannot open the config file: " + fileName;
+		return false;
+	}
+
+	std::string line;
+	unsigned int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		++lineNumber;
+
+		const size_t comment = line.find('#');
+		if (std::string::npos != comment) line.erase(comment);
+
+		line = Trim(line);
+		if (line.empty()) continue;
+
+		const size_t pos = line.find('=');
+		const std::string name = Trim(line.substr(0, pos));
+		const std::string value = std::string::npos == pos ? "" : Trim(line.substr(pos + 1));
+
+		if ("config" == name || "help" == name || !Set(name, value, std::string::npos != pos))
+		{
+			if (error.empty()) error = "Unexpected parameter: " + name;
+			error += " (" + fileName + ", line " + std::to_string(lineNumber) + ")";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+bool Parameters::isFlag(const std::string& name)
+{
+	return "help" == name || "bessel-test" == name || "adaptive-l" == name || "adaptive-energy" == name || "adaptive-steps" == name || "fit-mass" == name || "clear-cache" == name;
+}
+
+
+int Parameters::FindPair(const std::string& value)
+{
+	for (size_t i = 0; i < ComputeOptions::scatteringPairs.size(); ++i)
+		if (value == ComputeOptions::scatteringPairs[i].pairName) return static_cast<int>(i);
+
+	int index = -1;
+	if (!ParseInt(value, index) || index >= static_cast<int>(ComputeOptions::scatteringPairs.size()))
+		return -1;
+
+	return index;
+}
+
+
+bool Parameters::Set(const std::string& name, const std::string& value, bool hasValue)
+{
+	bool ok = true;
+
+	if (!hasValue && !isFlag(name))
+	{
+		error = "Missing value for " + name;
+		return false;
+	}
+
+	if ("help" == name) help = true;
+	else if ("bessel-test" == name) besselTest = true;
+	else if ("output" == name) outputFile = value;
+	else if ("cache" == name) cacheDirectory = value;
+	else if ("cache-size" == name) ok = ParseInt(value, cacheSize) && cacheSize > 0;
+	else if ("clear-cache" == name) ok = ParseBool(hasValue ? value : "1", clearCache);
+	else if ("format" == name)
+	{
+		ok = "text" == value || "csv" == value;
+		csv = "csv" == value;
+	}
+	else if ("pair" == name)
+	{
+		const int index = FindPair(value);
+		ok = index >= 0;
+		if (ok)
+		{
+			options.scatteringPair = index;
+			pairs.clear();
+		}
+	}
+	else if ("pairs" == name)
+	{
+		pairs.clear();
+
+		if ("all" == value)
+		{
+			for (size_t i = 0; i < ComputeOptions::scatteringPairs.size(); ++i)
+				pairs.push_back(static_cast<int>(i));
+		}
+		else
+		{
+			size_t start = 0;
+			while (ok && start <= value.size())
+			{
+				size_t end = value.find(',', start);
+				if (std::string::npos == end) end = value.size();
+
+				const int index = FindPair(Trim(value.substr(start, end - start)));
+				ok = index >= 0;
+				if (ok) pairs.push_back(index);
+
+				start = end + 1;
+			}
+		}
+	}
+	else if ("potential" == name)
+	{
+		const int type = FindName(potentialNames, value);
+		ok = type >= 0;
+		if (ok) options.potentialType = type;
+	}
+	else if ("engine" == name)
+	{
+		const int engine = FindName(engineNames, value);
+		ok = engine >= 0;
+		if (ok) options.engine = engine;
+	}
+	else if ("bessel" == name)
+	{
+		const int method = FindName(besselNames, value);
+		ok = method >= 0;
+		if (ok) options.besselMethod = method;
+	}
+	else if ("gamma" == name) ok = ParseDouble(value, options.gamma);
+	else if ("points" == name) ok = ParseInt(value, options.nrPoints) && options.nrPoints > 0;
+	else if ("steps" == name) ok = ParseInt(value, options.nrIntegrationSteps) && options.nrIntegrationSteps > 0;
+	else if ("threads" == name) ok = ParseInt(value, options.nrThreads) && options.nrThreads >= 0;
+	else if ("adaptive-l" == name) ok = ParseBool(hasValue ? value : "1", options.adaptivePartialWaves);
+	else if ("max-l" == name) ok = ParseInt(value, options.maxPartialWaves) && options.maxPartialWaves >= 0 && options.maxPartialWaves <= ComputeOptions::maxPartialWavesAllowed;
+	else if ("l-tolerance" == name) ok = ParseDouble(value, options.partialWavesTolerance) && options.partialWavesTolerance > 0;
+	else if ("negligible-l" == name)
+	{
+		int nr = 0;
+		ok = ParseInt(value, nr) && nr > 0;
+		if (ok) options.negligiblePartialWaves = static_cast<unsigned int>(nr);
+	}
+	else if ("adaptive-energy" == name) ok = ParseBool(hasValue ? value : "1", options.adaptiveEnergyGrid);
+	else if ("energy-tolerance" == name) ok = ParseDouble(value, options.energyTolerance) && options.energyTolerance > 0;
+	else if ("max-phase-change" == name) ok = ParseDouble(value, options.maxPhaseShiftChange) && options.maxPhaseShiftChange > 0;
+	else if ("adaptive-steps" == name) ok = ParseBool(hasValue ? value : "1", options.adaptiveIntegration);
+	else if ("accuracy" == name) ok = ParseDouble(value, options.phaseShiftAccuracy) && options.phaseShiftAccuracy > 0;
+	else if ("max-steps" == name) ok = ParseInt(value, options.maxIntegrationSteps) && options.maxIntegrationSteps > 0;
+	else if ("fit" == name) fitFile = value;
+	else if ("fit-mass" == name) ok = ParseBool(hasValue ? value : "1", fitSettings.fitMass);
+	else if ("fit-iterations" == name)
+	{
+		int nr = 0;
+		ok = ParseInt(value, nr) && nr > 0;
+		if (ok) fitSettings.maxIterations = static_cast<unsigned int>(nr);
+	}
+	else if ("fit-epsilon" == name) ok = ParseDouble(value, fitEpsilon) && fitEpsilon > 0;
+	else if ("fit-rho" == name) ok = ParseDouble(value, fitRho) && fitRho > 0;
+	else if ("llim" == name) ok = ParseInt(value, options.partialWavesLimit) && options.partialWavesLimit >= 0 && options.partialWavesLimit <= ComputeOptions::maxPartialWavesAllowed;
+	else
+	{
+		error = "Unknown parameter: " + name;
+		return false;
+	}
+
+	if (!ok) error = "Invalid value for " + name + ": " + value;
+
+	return ok;
+}
+
+
+bool Parameters::ParseBool(const std::string& value, bool& result)
+{
+	if ("1" == value || "true" == value || "yes" == value || "on" == value) result = true;
+	else if ("0" == value || "false" == value || "no" == value || "off" == value) result = false;
+	else return false;
+
+	return true;
+}
+
+
+bool Parameters::ParseInt(const std::string& value, int& result)
+{
+	if (value.empty()) return false;
+
+	char* end = nullptr;
+	errno = 0;
+	const long val = strtol(value.c_str(), &end, 10);
+	if (0 != errno || *end || val < INT_MIN || val > INT_MAX) return false;
+
+	result = static_cast<int>(val);
+
+	return true;
+}
+
+
+bool Parameters::ParseDouble(const std::string& value, double& result)
+{
+	if (value.empty()) return false;
+
+	char* end = nullptr;
+	errno = 0;
+	const double val = strtod(value.c_str(), &end);
+	if (0 != errno || *end) return false;
+
+	result = val;
+
+	return true;
+}
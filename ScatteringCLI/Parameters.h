@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "ComputeOptions.h"
+#include "Fit.h"
+#include "ResultCache.h"
+
+// the parameters for the command line program
+// they are given as --name value (or --name=value) in the command line, or as name = value lines in a file passed with --config
+// the ones in the command line override the ones from the file, whatever their order
+class Parameters
+{
+public:
+	// false if something is wrong, the reason is in error
+	bool Parse(int argc, char* argv[]);
+
+	static void PrintUsage(FILE* file);
+
+	ComputeOptions options;
+	std::vector<int> pairs; // if not empty, these pairs are computed at once instead of the one in options
+	std::string outputFile; // empty for stdout
+	std::string cacheDirectory; // empty for no files for the results cache
+	int cacheSize = static_cast<int>(Scattering::ResultCache::defaultMaxDiskBytes / (1024 * 1024)); // MB, over it the least recently used files are deleted
+	bool clearCache = false; // deletes the files in cacheDirectory before computing
+	bool csv = false;
+
+	std::string fitFile; // if not empty, the measurements to fit the potential parameters to
+	Scattering::FitSettings fitSettings;
+	double fitEpsilon = 0; // the start values, 0 for the ones of the pair
+	double fitRho = 0;
+	bool help = false;
+	bool besselTest = false;
+
+	std::string error;
+
+private:
+	bool Load(const std::string& fileName);
+	bool Set(const std::string& name, const std::string& value, bool hasValue);
+
+	static bool isFlag(const std::string& name);
+
+	static int FindPair(const std::string& value);
+
+	static bool ParseBool(const std::string& value, bool& result);
+	static bool ParseInt(const std::string& value, int& result);
+	static bool ParseDouble(const std::string& value, double& result);
+};
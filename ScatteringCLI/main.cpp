@@ -0,0 +1,119 @@
+// command line program for computing the cross sections without the GUI
+// see Parameters::PrintUsage for the parameters
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Parameters.h"
+#include "Scattering.h"
+#include "BesselTest.h"
+#include "Export.h"
+
+
+int main(int argc, char* argv[])
+{
+	Parameters parameters;
+
+	if (!parameters.Parse(argc, argv))
+	{
+		fprintf(stderr, "%s\n\n", parameters.error.c_str());
+		Parameters::PrintUsage(stderr);
+		return 1;
+	}
+	else if (parameters.help)
+	{
+		Parameters::PrintUsage(stdout);
+		return 0;
+	}
+
+	const ComputeOptions& options = parameters.options;
+
+	if (parameters.besselTest)
+	{
+		const std::vector<Scattering::BesselTest::Result> results = Scattering::BesselTest::Run(options);
+		fputs(Scattering::BesselTest::Report(options, results).c_str(), stdout);
+		return 0;
+	}
+
+	std::vector<Scattering::Measurement> measurements;
+	if (!parameters.fitFile.empty() && !Scattering::Fit::LoadMeasurements(parameters.fitFile, measurements, parameters.error))
+	{
+		fprintf(stderr, "%s\n", parameters.error.c_str());
+		return 1;
+	}
+
+	FILE* file = stdout;
+	if (!parameters.outputFile.empty())
+	{
+		file = fopen(parameters.outputFile.c_str(), "w");
+		if (!file)
+		{
+			fprintf(stderr, "Cannot open the output file: %s\n", parameters.outputFile.c_str());
+			return 1;
+		}
+	}
+
+	// the lines are written at once, at the end
+	static char buffer[1 << 16];
+	setvbuf(file, buffer, _IOFBF, sizeof(buffer));
+
+	Scattering::ComputeContext context(options.nrThreads > 0 ? static_cast<unsigned int>(options.nrThreads) : 0U);
+	if (parameters.clearCache) Scattering::ResultCache::RemoveFiles(parameters.cacheDirectory);
+	context.resultCache.setDirectory(parameters.cacheDirectory, static_cast<size_t>(parameters.cacheSize) * 1024 * 1024);
+
+	const std::vector<int> pairs = parameters.pairs.empty() ? std::vector<int>{ options.scatteringPair } : parameters.pairs;
+
+	std::vector<std::string> names;
+	for (int pair : pairs)
+		names.push_back(options.scatteringPairs[pair].pairName);
+
+	std::vector<Scattering::Results> results;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	if (measurements.empty())
+		results = Scattering::Scattering::Compute(options, pairs, context);
+	else
+	{
+		// the fit starts from the parameters of the pair, if not given, the results are computed with the fitted ones
+		Scattering::ScatteringPair startPair = options.scatteringPairs[options.scatteringPair];
+		if (parameters.fitEpsilon > 0) startPair.epsilon = parameters.fitEpsilon;
+		if (parameters.fitRho > 0) startPair.rho = parameters.fitRho;
+
+		const Scattering::Fit::Result fit = Scattering::Fit::Run(options, startPair, measurements, context, parameters.fitSettings, [](unsigned int iteration, double chiSquare, const Scattering::ScatteringPair& pair)
+		{
+			fprintf(stderr, "Iteration %u: chi square %g, epsilon %g meV, rho %g A, m2 %g\n", iteration, chiSquare, pair.epsilon, pair.rho, pair.m2);
+		});
+
+		fprintf(file, "# fit to %zu measurements from %s, %s after %u iterations\n", measurements.size(), parameters.fitFile.c_str(), fit.converged ? "converged" : "not converged", fit.iterations);
+		fprintf(file, "# chi square: %.10g\n", fit.chiSquare);
+		fprintf(file, "# epsilon: %.10g +- %.3g meV\n", fit.pair.epsilon, fit.epsilonError);
+		fprintf(file, "# rho: %.10g +- %.3g A\n", fit.pair.rho, fit.rhoError);
+		if (parameters.fitSettings.fitMass) fprintf(file, "# m2: %.10g +- %.3g\n", fit.pair.m2, fit.massError);
+
+		names.assign(1, startPair.pairName + " fit");
+		results.push_back(Scattering::Scattering::Compute(options, fit.pair, context));
+	}
+
+	const auto end = std::chrono::steady_clock::now();
+
+	size_t nrPoints = 0;
+	for (const auto& pairResults : results)
+		nrPoints += pairResults.size();
+
+	bool ok = parameters.csv ? Scattering::Export::WriteCSV(file, names, results) : Scattering::Export::WriteText(file, names, results);
+	ok = 0 == fflush(file) && ok;
+	if (stdout != file) ok = 0 == fclose(file) && ok;
+
+	if (!ok)
+	{
+		fprintf(stderr, "Error writing the results\n");
+		return 1;
+	}
+
+	fprintf(stderr, "%zu points computed in %.3f s\n", nrPoints, std::chrono::duration<double>(end - start).count());
+
+	return 0;
+}
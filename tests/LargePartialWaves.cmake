@@ -0,0 +1,28 @@
+# runs the command line program with the maximum partial waves near the largest value allowed in the options (1000)
+# there the Bessel functions n and the Numerov solution overflow for the low energies, the cross sections must stay finite
+# usage: cmake -DCLI=path/to/ScatteringCLI -P LargePartialWaves.cmake
+
+set(runs
+	"--llim 1000 --bessel stable"
+	"--llim 1000 --bessel upward"
+	"--llim 1000 --bessel std"
+	"--llim 1000 --engine logderiv"
+	"--adaptive-l --max-l 1000 --l-tolerance 1e-12"
+)
+
+foreach(run IN LISTS runs)
+	separate_arguments(args UNIX_COMMAND "${run}")
+
+	execute_process(COMMAND "${CLI}" --points 200 ${args} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE errors)
+
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "ScatteringCLI ${run} failed: ${errors}")
+	endif()
+
+	string(TOLOWER "${output}" output)
+	if(output MATCHES "nan|inf")
+		message(FATAL_ERROR "ScatteringCLI ${run} gave cross sections that are not finite")
+	endif()
+
+	message(STATUS "ScatteringCLI ${run}: ok")
+endforeach()